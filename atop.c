@@ -142,6 +142,7 @@
 #include <regex.h>
 #include <glib.h>
 #include <sys/inotify.h>
+#include <pthread.h>
 
 #include "atop.h"
 #include "acctproc.h"
@@ -155,6 +156,7 @@
 #include "json.h"
 #include "gpucom.h"
 #include "netatop.h"
+#include "stagecost.h"
 
 #define	allflags  "ab:cde:fghijklmnopqrstuvwxyz:123456789ABCDEFGHIJ:KL:MNOP:QRSTUVWXYZ"
 #define	MAXFL		84      /* maximum number of command-line flags  */
@@ -185,6 +187,15 @@ char      	usecolors  = 1;  /* boolean: colors for high occupation  */
 char		threadview = 0;	 /* boolean: show individual threads     */
 char      	calcpss    = 0;  /* boolean: read/calculate process PSS  */
 char      	getwchan   = 0;  /* boolean: obtain wchan string         */
+int		procthreads = 1; /* number of threads gathering tasks    */
+int		pssbudget   = 0; /* max. processes with PSS refresh      */
+int		procinterval = 0;/* min. seconds between process samples */
+char		alignsamples = 0;/* boolean: align samples to wall clock */
+char		parallelstages = 0;/* boolean: system-level and process-  */
+				 /* level counters gathered in parallel  */
+unsigned int	sampdelay;	 /* msecs between scheduled and actual   */
+				 /* start of the current sample          */
+unsigned int	sampcollect;	 /* msecs needed to gather current sample*/
 char      	rmspaces   = 0;  /* boolean: remove spaces from command  */
 		                 /* name in case of parsable output      */
 
@@ -220,6 +231,8 @@ int		numhandlers;
 ** argument values
 */
 static char		awaittrigger;	/* boolean: awaiting trigger */
+static struct timespec	nextsample;	/* scheduled time next sample */
+static struct timespec	schedsample;	/* scheduled time last sample */
 static unsigned int 	nsamples = 0xffffffff;
 static char		midnightflag;
 static char		rawwriteflag;
@@ -236,7 +249,20 @@ static void		readrc(char *, int);
 
 static void do_interval(char *, char *);
 static void do_linelength(char *, char *);
+static void do_procthreads(char *, char *);
+static void do_pssbudget(char *, char *);
+static void do_procinterval(char *, char *);
+static void do_alignsamples(char *, char *);
+static void do_parallelstages(char *, char *);
 
+/*
+** sysonly: 0 - tag name allowed in every atoprc
+**          1 - tag name only allowed in /etc/atoprc
+**          2 - tag name not allowed when running setuid-root, because
+**              the effective uid is shared by all threads of atop
+**              and the root privileges could not be dropped while
+**              several threads gather counters in parallel
+*/
 static struct {
 	char	*tag;
 	void	(*func)(char *, char *);
@@ -272,6 +298,7 @@ static struct {
 	{	"ownmemnumaline",	do_ownmemnumaline,	0, },
 	{	"ownnumacpuline",	do_owncpunumaline,	0, },
 	{	"ownllcline",		do_ownllcline,		0, },
+	{	"ownstagecostline",	do_ownstagecostline,	0, },
 	{	"owndskline",		do_owndskline,		0, },
 	{	"ownnettrline",		do_ownnettransportline,	0, },
 	{	"ownnetnetline",	do_ownnetnetline,	0, },
@@ -290,13 +317,40 @@ static struct {
 	{	"almostcrit",		do_almostcrit,		0, },
 	{	"atopsarflags",		do_atopsarflags,	0, },
 	{	"perfevents",		do_perfevents,		0, },
+	{	"perfextra",		do_perfextra,		0, },
+	{	"procthreads",		do_procthreads,		2, },
+	{	"procfdcache",		do_procfdcache,		0, },
+	{	"taskstats",		do_taskstats,		0, },
+	{	"skipidlethreads",	do_skipidlethreads,	0, },
+	{	"cacheprocinfo",	do_cacheprocinfo,	0, },
+	{	"pssbudget",		do_pssbudget,		0, },
+	{	"procinterval",		do_procinterval,	0, },
+	{	"alignsamples",		do_alignsamples,	0, },
+	{	"parallelstages",	do_parallelstages,	2, },
+	{	"stagecostline",	do_stagecostline,	0, },
 	{	"pacctdir",		do_pacctdir,		1, },
 };
 
+/*
+** stage that gathers the system-level counters, the cgroup-level
+** counters and the response of atopgpud, possibly in a separate
+** thread while the main thread gathers the process-level counters
+*/
+struct sysstage {
+	struct sstat		*sstat;		/* system-level counters    */
+	char			cgroups;	/* boolean: gather cgroups  */
+	char			gpupending;	/* boolean: request sent    */
+	char			inthread;	/* boolean: separate thread */
+	int			nrgpuproc;	/* number of GPU processes  */
+	struct gpupidstat	*gp;		/* GPU process stats        */
+};
+
 /*
 ** internal prototypes
 */
 static void	engine(void);
+static void	*sysstage(void *);
+static unsigned int	tsdiffms(struct timespec *, struct timespec *);
 static void	twinprepare(void);
 static void	twinclean(void);
 
@@ -350,10 +404,18 @@ main(int argc, char *argv[])
 	if ( strcmp(p, "atopsar") == 0)
 		return atopsar(argc, argv);
 
+	/*
+	** check if we are supposed to behave as 'atopbench'
+	** i.e. benchmark of gathering the counters
+	*/
+	if ( strcmp(p, "atopbench") == 0)
+	{
+		nsamples = atopbench(argc, argv);
+	}
 	/* 
 	** interpret command-line arguments & flags 
 	*/
-	if (argc > 1)
+	else if (argc > 1)
 	{
 		/* 
 		** gather all flags for visualization-functions
@@ -739,22 +801,35 @@ engine(void)
 	*/
 	static struct tstat	*curtpres;	/* current present list      */
 	static unsigned long	 curtlen;	/* size of present list      */
+						/* (reused for every sample) */
 	struct tstat		*curpexit;	/* exited process list	     */
 
 	static struct devtstat	devtstat;	/* deviation info	     */
 
-	unsigned long		ntaskpres;	/* number of tasks present   */
+	struct timespec		samplestart, samplestop, samplewall;
+
+	unsigned long		ntaskpres = 0;	/* number of tasks present   */
 	unsigned long		nprocexit;	/* number of exited procs    */
 	unsigned long		nprocexitnet;	/* number of exited procs    */
 						/* via netatopd daemon       */
 
 	unsigned long		noverflow;
 
+	static time_t		proctime;	/* time of last process-level */
+						/* sample                     */
+	int			procsample;	/* boolean: process-level     */
+						/* counters in this sample    */
+
 	int         		nrgpuproc=0,	/* number of GPU processes    */
 				gpupending=0;	/* boolean: request sent      */
 
 	struct gpupidstat	*gp = NULL;
 
+	struct sysstage		stage;		/* system-level stage        */
+	pthread_t		stagetid;
+	char			stagerunning = 0;
+	struct stgmark		stgmark;	/* start of measured stage   */
+
 	/*
 	** initialization: allocate required memory dynamically
 	*/
@@ -783,7 +858,9 @@ engine(void)
 	sigaction(SIGALRM, &sigact, (struct sigaction *)0);
 
 	if (interval > 0)
-		alarm(interval);
+		getalarm(0);	/* start the timer */
+
+	proctime = curtime;
 
 	if (midnightflag)
 	{
@@ -845,10 +922,35 @@ engine(void)
 		awaittrigger = 1;
 
 		/*
-		** gather time info for this sample
+		** determine the delay between the scheduled time of
+		** this sample and the actual start of the sample
 		*/
+		clock_gettime(CLOCK_MONOTONIC, &samplestart);
+
+		if (sampcnt > 0 && schedsample.tv_sec)
+			sampdelay = tsdiffms(&samplestart, &schedsample);
+		else
+			sampdelay = 0;
+
+		schedsample.tv_sec = 0;
+
+		/*
+		** gather time info for this sample (not via time() that
+		** might lag behind the wall clock, which matters for
+		** samples aligned to a second boundary)
+		*/
+		clock_gettime(CLOCK_REALTIME, &samplewall);
+
 		pretime  = curtime;
-		curtime  = time(0);		/* seconds since 1-1-1970 */
+		curtime  = samplewall.tv_sec;	/* seconds since 1-1-1970 */
+
+		/*
+		** determine if the process-level and cgroup-level counters
+		** are gathered during this sample; with 'procinterval' the
+		** system-level counters can be sampled more frequently
+		** than the (more expensive) process-level counters
+		*/
+		procsample = sampcnt == 0 || curtime - proctime >= procinterval;
 
 		/*
 		** send request for statistics to atopgpud 
@@ -868,165 +970,240 @@ engine(void)
 		cursstat = presstat;
 		presstat = hlpsstat;
 
-		photosyst(cursstat);	/* obtain new system-level counters */
+		stgclear();		/* clear costs of previous sample */
 
-		/*
-		** take a snapshot of the current cgroup-level metrics 
-		** when cgroups v2 supported
-		*/
-		if ( (supportflags&CGROUPV2) )
-			photocgroup();
+		stage.sstat      = cursstat;
+		stage.cgroups    = (supportflags&CGROUPV2) && procsample;
+		stage.gpupending = gpupending;
+		stage.inthread   = 0;
 
 		/*
-		** receive and parse response from atopgpud
+		** with 'parallelstages' the system-level (and cgroup-level)
+		** counters are gathered by a separate thread, while the
+		** process-level counters are gathered by the main thread;
+		** the first sample is taken serially because of the one-time
+		** initializations of both stages
 		*/
-		if (nrgpus && gpupending)
+		if (parallelstages && sampcnt > 0 && procsample)
 		{
-			nrgpuproc = gpud_statresponse(nrgpus, cursstat->gpu.gpu, &gp);
+			sigset_t	allsigs, oldsigs;
 
-			gpupending = 0;
+			/*
+			** the signals should be handled by the main thread
+			*/
+			sigfillset(&allsigs);
+			pthread_sigmask(SIG_BLOCK, &allsigs, &oldsigs);
 
-			// connection lost or timeout on receive?
-			if (nrgpuproc == -1)
+			stage.inthread = 1;
+
+			if (pthread_create(&stagetid, NULL, sysstage, &stage) == 0)
 			{
-				nrgpus = 0;
-				supportflags &= ~GPUSTAT;
+				stagerunning = 1;
+			}
+			else
+			{
+				stage.inthread = 0;
+				sysstage(&stage);
 			}
 
-			cursstat->gpu.nrgpus = nrgpus;
+			pthread_sigmask(SIG_SETMASK, &oldsigs, NULL);
+		}
+		else
+		{
+			sysstage(&stage);
 		}
 
-		deviatsyst(cursstat, presstat, devsstat,
-				curtime-pretime > 0 ? curtime-pretime : 1);
+		gpupending = 0;
 
+		if (!procsample)
+		{
+			/*
+			** on samples without process-level counters, the
+			** deviations of the previous process-level sample
+			** are kept (shown by the interactive display only)
+			*/
+			curpexit     = NULL;
+			nprocexit    = 0;
+			nprocexitnet = 0;
+			noverflow    = 0;
+		}
+		else
+		{
+			/*
+			** take a snapshot of the current task-level statistics 
+			** and calculate the deviations (i.e. calculate the activity
+			** during the last sample)
+			**
+			** first register active tasks
+			*/
+			stgstart(&stgmark, 0);
 
-		/*
-		** take a snapshot of the current task-level statistics 
-		** and calculate the deviations (i.e. calculate the activity
-		** during the last sample)
-		**
-		** first register active tasks
-		*/
-		curtpres  = NULL;
+			ntaskpres = photoproc(&curtpres, &curtlen);
 
-		do
-		{
-			curtlen   = counttasks();	// worst-case value
-			curtpres  = realloc(curtpres,
-					curtlen * sizeof(struct tstat));
+			stgstop(&stgmark, STGPROC);
 
-			ptrverify(curtpres, "Malloc failed for %lu tstats\n",
-								curtlen);
+			/*
+			** register processes that exited during last sample;
+			** first determine how many processes exited
+			**
+			** the number of exited processes is limited to avoid
+			** that atop explodes in memory and introduces OOM killing
+			*/
+			stgstart(&stgmark, 0);
 
-			memset(curtpres, 0, curtlen * sizeof(struct tstat));
+			nprocexit = acctprocnt();	/* number of exited processes */
+
+			if (nprocexit > MAXACCTPROCS)
+			{
+				noverflow = nprocexit - MAXACCTPROCS;
+				nprocexit = MAXACCTPROCS;
+			}
+			else
+				noverflow = 0;
+
+			/*
+			** determine how many processes have been exited
+			** for the netatop module (only processes that have
+			** used the network)
+			*/
+			if (nprocexit > 0 && (supportflags & NETATOPD))
+				nprocexitnet = netatop_exitstore();
+			else
+				nprocexitnet = 0;
+
+			/*
+			** reserve space for the exited processes and read them
+			*/
+			if (nprocexit > 0)
+			{
+				curpexit = malloc(nprocexit * sizeof(struct tstat));
+
+				ptrverify(curpexit,
+				          "Malloc failed for %lu exited processes\n",
+				          nprocexit);
+
+				memset(curpexit, 0, nprocexit * sizeof(struct tstat));
+
+				nprocexit = acctphotoproc(curpexit, nprocexit);
+
+				/*
+	 			** reposition offset in accounting file when not
+				** all exited processes have been read (i.e. skip
+				** those processes)
+				*/
+				if (noverflow)
+					acctrepos(noverflow);
+			}
+			else
+			{
+				curpexit    = NULL;
+			}
+
+			stgstop(&stgmark, STGACCT);
 		}
-		while ( (ntaskpres = photoproc(curtpres, curtlen)) == curtlen);
 
 		/*
-		** register processes that exited during last sample;
-		** first determine how many processes exited
-		**
-		** the number of exited processes is limited to avoid
-		** that atop explodes in memory and introduces OOM killing
+		** wait for the system-level stage to complete
 		*/
-		nprocexit = acctprocnt();	/* number of exited processes */
-
-		if (nprocexit > MAXACCTPROCS)
+		if (stagerunning)
 		{
-			noverflow = nprocexit - MAXACCTPROCS;
-			nprocexit = MAXACCTPROCS;
+			pthread_join(stagetid, NULL);
+			stagerunning = 0;
 		}
-		else
-			noverflow = 0;
 
-		/*
-		** determine how many processes have been exited
-		** for the netatop module (only processes that have
-		** used the network)
-		*/
-		if (nprocexit > 0 && (supportflags & NETATOPD))
-			nprocexitnet = netatop_exitstore();
-		else
-			nprocexitnet = 0;
+		nrgpuproc = stage.nrgpuproc;
+		gp        = stage.gp;
 
-		/*
-		** reserve space for the exited processes and read them
-		*/
-		if (nprocexit > 0)
+		if (nrgpuproc == -1)	// connection lost or timeout on receive?
 		{
-			curpexit = malloc(nprocexit * sizeof(struct tstat));
+			nrgpus = 0;
+			supportflags &= ~GPUSTAT;
+		}
 
-			ptrverify(curpexit,
-			          "Malloc failed for %lu exited processes\n",
-			          nprocexit);
+		stgstart(&stgmark, 0);
 
-			memset(curpexit, 0, nprocexit * sizeof(struct tstat));
+		deviatsyst(cursstat, presstat, devsstat,
+				curtime-pretime > 0 ? curtime-pretime : 1);
 
-			nprocexit = acctphotoproc(curpexit, nprocexit);
+		stgstop(&stgmark, STGDSYS);
+
+		if (procsample)
+		{
+			stgstart(&stgmark, 0);
 
 			/*
- 			** reposition offset in accounting file when not
-			** all exited processes have been read (i.e. skip
-			** those processes)
+	 		** merge GPU per-process stats with other per-process stats
 			*/
-			if (noverflow)
-				acctrepos(noverflow);
-		}
-		else
-		{
-			curpexit    = NULL;
-		}
+			if (nrgpus && nrgpuproc > 0)
+				gpumergeproc(curtpres, ntaskpres,
+			                     curpexit, nprocexit,
+			 	             gp,       nrgpuproc);
 
-		/*
- 		** merge GPU per-process stats with other per-process stats
-		*/
-		if (nrgpus && nrgpuproc > 0)
-			gpumergeproc(curtpres, ntaskpres,
-		                     curpexit, nprocexit,
-		 	             gp,       nrgpuproc);
+			/*
+			** calculate process-level deviations
+			*/
+			deviattask(curtpres, ntaskpres, curpexit, nprocexit,
+			                     &devtstat, devsstat,
+				curtime-pretime  > 0 ? curtime-pretime  : 1,
+				curtime-proctime > 0 ? curtime-proctime : 1);
 
-		/*
-		** calculate process-level deviations
-		*/
-		deviattask(curtpres, ntaskpres, curpexit, nprocexit,
-		                     &devtstat, devsstat);
+			proctime = curtime;
 
-		if (supportflags & NETATOPBPF)
-		{
-			g_hash_table_destroy(ghash_net);
-			ghash_net = NULL;
+			if (supportflags & NETATOPBPF)
+			{
+				g_hash_table_destroy(ghash_net);
+				ghash_net = NULL;
+			}
+
+			/*
+			** calculate cgroup-level v2 deviations
+			**
+			** allocation and deallocation of structs
+			** is arranged at a lower level
+			*/
+			if ( (supportflags&CGROUPV2) )
+				ncgroups = deviatcgroup(&devcstat, &npids);
+
+			stgstop(&stgmark, STGDTSK);
 		}
 
 		/*
-		** calculate cgroup-level v2 deviations
-		**
-		** allocation and deallocation of structs
-		** is arranged at a lower level
+		** determine the time needed to gather this sample
 		*/
-		if ( (supportflags&CGROUPV2) )
-			ncgroups = deviatcgroup(&devcstat, &npids);
+		clock_gettime(CLOCK_MONOTONIC, &samplestop);
+
+		sampcollect = tsdiffms(&samplestop, &samplestart);
 
 		/*
 		** activate the installed print function to visualize
 		** the deviations
 		*/
+		stgstart(&stgmark, 0);
+
 		for (i=0; handlers[i].handle_sample; i++)
 		{
 			lastcmd = (handlers[i].handle_sample)(curtime,
 				     curtime-pretime > 0 ? curtime-pretime : 1,
 		           	     &devtstat, devsstat,
 				     devcstat, ncgroups, npids,
-		                     nprocexit, noverflow, sampcnt==0);
+		                     nprocexit, noverflow,
+				     (sampcnt==0 ? RRBOOT   : 0) |
+				     (procsample ? 0 : RRNOPROC));
 		}
 
+		/*
+		** the interactive display only returns when the next
+		** sample is due, so then the output costs are not known
+		*/
+		if (!screen)
+			stgstop(&stgmark, STGOUTP);
+
 		/*
 		** release dynamically allocated memory
 		*/
 		if (nprocexit > 0)
 			free(curpexit);
 
-		free(curtpres);
-
 		if ((supportflags & NETATOPD) && (nprocexitnet > 0))
 			netatop_exiterase();
 
@@ -1052,6 +1229,51 @@ engine(void)
 	} /* end of main-loop */
 }
 
+/*
+** gather the system-level counters, the cgroup-level counters
+** (if required) and the response of atopgpud (if requested)
+*/
+static void *
+sysstage(void *arg)
+{
+	struct sysstage	*sp = arg;
+	struct stgmark	stgmark;
+
+	stgstart(&stgmark, sp->inthread);
+
+	photosyst(sp->sstat);	/* obtain new system-level counters */
+
+	stgstop(&stgmark, STGSYST);
+
+	/*
+	** take a snapshot of the current cgroup-level metrics 
+	** when cgroups v2 supported
+	*/
+	if (sp->cgroups)
+	{
+		stgstart(&stgmark, sp->inthread);
+		photocgroup();
+		stgstop(&stgmark, STGCGRP);
+	}
+
+	/*
+	** receive and parse response from atopgpud
+	*/
+	sp->nrgpuproc = 0;
+	sp->gp        = NULL;
+
+	if (nrgpus && sp->gpupending)
+	{
+		sp->nrgpuproc = gpud_statresponse(nrgpus, sp->sstat->gpu.gpu,
+								&sp->gp);
+
+		// connection lost or timeout on receive?
+		sp->sstat->gpu.nrgpus = sp->nrgpuproc == -1 ? 0 : nrgpus;
+	}
+
+	return NULL;
+}
+
 /*
 ** print usage of this command
 */
@@ -1119,15 +1341,138 @@ prusage(char *myname)
 }
 
 /*
-** handler for ALRM-signal
+** handler for ALRM-signal, also called directly (signal number 0)
+** to (re)start the timer
+**
+** the timer is (re)started with the time until the next scheduled
+** sample on the monotonic clock instead of the interval itself, so
+** the samples do not drift by the time needed to gather them;
+** with 'alignsamples' the samples are scheduled on a multiple
+** of the interval on the wall clock
+**
+** the interval timer of setitimer() is shared with alarm(), so
+** the interactive commands can still stop the clock with alarm(0);
+** a short timer to force the next sample is set with setalarm()
 */
 void
 getalarm(int sig)
 {
+	struct timespec		now, wall;
+	struct itimerval	itv;
+	long long		nsecs;
+
 	awaittrigger=0;
 
-	if (interval > 0)
-		alarm(interval);	/* restart the timer */
+	if (interval == 0)
+		return;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	/*
+	** an expiry that is more than one interval before the scheduled
+	** time stems from a timer that has not been set by getalarm()
+	** or setalarm(), e.g. after a change of the interval, and is
+	** handled as a restart
+	*/
+	if (sig && nextsample.tv_sec - now.tv_sec <= interval)
+	{				/* timer expired */
+		schedsample = nextsample;
+	}
+	else				/* explicit (re)start */
+	{
+		schedsample.tv_sec = 0;
+		nextsample         = now;
+	}
+
+	if (alignsamples)
+	{
+		clock_gettime(CLOCK_REALTIME, &wall);
+
+		nsecs = (interval - wall.tv_sec % interval) * 1000000000LL -
+								wall.tv_nsec;
+
+		nextsample.tv_sec  = now.tv_sec  + nsecs / 1000000000LL;
+		nextsample.tv_nsec = now.tv_nsec + nsecs % 1000000000LL;
+
+		if (nextsample.tv_nsec >= 1000000000L)
+		{
+			nextsample.tv_sec++;
+			nextsample.tv_nsec -= 1000000000L;
+		}
+	}
+	else
+	{
+		/*
+		** skip the scheduled samples that have been missed
+		*/
+		if (nextsample.tv_sec < now.tv_sec)
+			nextsample.tv_sec += (now.tv_sec - nextsample.tv_sec) /
+							interval * interval;
+
+		do
+		{
+			nextsample.tv_sec += interval;
+		}
+		while (nextsample.tv_sec <  now.tv_sec ||
+		      (nextsample.tv_sec == now.tv_sec &&
+		       nextsample.tv_nsec <= now.tv_nsec));
+
+		nsecs = (nextsample.tv_sec  - now.tv_sec) * 1000000000LL +
+			 nextsample.tv_nsec - now.tv_nsec;
+	}
+
+	memset(&itv, 0, sizeof itv);
+
+	itv.it_value.tv_sec  = nsecs / 1000000000LL;
+	itv.it_value.tv_usec = nsecs % 1000000000LL / 1000;
+
+	if (itv.it_value.tv_sec == 0 && itv.it_value.tv_usec == 0)
+		itv.it_value.tv_usec = 1;
+
+	setitimer(ITIMER_REAL, &itv, (struct itimerval *)0);
+}
+
+/*
+** (re)start the timer to force the next sample after the given number
+** of seconds (instead of alarm), after which the samples are scheduled
+** with the regular interval from that moment
+*/
+void
+setalarm(int secs)
+{
+	struct itimerval	itv;
+
+	clock_gettime(CLOCK_MONOTONIC, &nextsample);
+
+	nextsample.tv_sec += secs;
+
+	memset(&itv, 0, sizeof itv);
+
+	itv.it_value.tv_sec = secs;
+
+	setitimer(ITIMER_REAL, &itv, (struct itimerval *)0);
+}
+
+/*
+** difference in milliseconds between two monotonic timestamps
+** (limited to the range of an unsigned short, as stored in
+** the raw file)
+*/
+static unsigned int
+tsdiffms(struct timespec *later, struct timespec *earlier)
+{
+	long long	msecs;
+
+	msecs = (later->tv_sec  - earlier->tv_sec) * 1000LL +
+	        (later->tv_nsec - earlier->tv_nsec) / 1000000;
+
+	if (msecs < 0)
+		return 0;
+
+	if (msecs > 0xffff)
+		return 0xffff;
+
+	return msecs;
 }
 
 /*
@@ -1164,6 +1509,49 @@ do_linelength(char *name, char *val)
 	linelen = get_posval(name, val);
 }
 
+static void
+do_procthreads(char *name, char *val)
+{
+	if ( (procthreads = get_posval(name, val)) == 0)
+		procthreads = 1;
+}
+
+static void
+do_pssbudget(char *name, char *val)
+{
+	pssbudget = get_posval(name, val);
+}
+
+static void
+do_procinterval(char *name, char *val)
+{
+	procinterval = get_posval(name, val);
+}
+
+static void
+do_alignsamples(char *name, char *val)
+{
+	if (strcmp(val, "enable") == 0)
+		alignsamples = 1;
+	else if (strcmp(val, "disable") == 0)
+		alignsamples = 0;
+	else
+		mcleanstop(1, "atoprc - %s: value 'enable' or 'disable' expected\n",
+								name);
+}
+
+static void
+do_parallelstages(char *name, char *val)
+{
+	if (strcmp(val, "enable") == 0)
+		parallelstages = 1;
+	else if (strcmp(val, "disable") == 0)
+		parallelstages = 0;
+	else
+		mcleanstop(1, "atoprc - %s: value 'enable' or 'disable' expected\n",
+								name);
+}
+
 /*
 ** read RC-file and modify defaults accordingly
 */
@@ -1235,7 +1623,20 @@ readrc(char *path, int syslevel)
 			{
 				if ( strcmp(tagname, manrc[i].tag) == 0)
 				{
-					if (manrc[i].sysonly && !syslevel)
+					if (manrc[i].sysonly == 2 &&
+					    rootprivs() && getuid() != 0)
+					{
+						fprintf(stderr,
+						   "%s: warning at line %2d "
+						   "- tag name %s not allowed "
+						   "for setuid-root atop\n",
+							path, line, tagname);
+
+						errorcnt++;
+						break;
+					}
+
+					if (manrc[i].sysonly == 1 && !syslevel)
 					{
 						fprintf(stderr,
 						   "%s: warning at line %2d "
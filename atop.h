@@ -68,6 +68,9 @@ struct netpertask;
 #define RRCONTAINERSTAT	0x0040
 #define RRGPUSTAT	0x0080
 #define RRCGRSTAT	0x0100
+#define RRPACKSSTAT	0x0200
+#define RRNOPROC	0x0400
+#define RRSTAGECOST	0x0800
 
 #define MAXHANDLERS	10
 
@@ -75,7 +78,7 @@ struct handler {
 	char	(*handle_sample)  (time_t, int,
        			struct devtstat *, struct sstat *,
 			struct cgchainer *, int, int, int,
-			unsigned int, char);
+			unsigned int, int);
 };
 
 /*
@@ -97,6 +100,10 @@ extern char		usecolors;
 extern char		threadview;
 extern char		calcpss;
 extern char		getwchan;
+extern int		procthreads;
+extern int		pssbudget;
+extern unsigned int	sampdelay;
+extern unsigned int	sampcollect;
 extern char		irawname[];
 extern char		orawname[];
 extern char		twindir[];
@@ -107,6 +114,7 @@ extern char		rmspaces;
 extern time_t		begintime, endtime, cursortime;	// epoch or time in day
 extern char		flaglist[];
 extern struct handler	handlers[];
+extern int		numhandlers;
 
 extern char		displaymode;
 extern char		barmono;
@@ -158,7 +166,7 @@ extern int		almostcrit;
 char		generic_samp (time_t, int,
 		            struct devtstat *, struct sstat *,
 			    struct cgchainer *, int, int,
-		            int, unsigned int, char);
+		            int, unsigned int, int);
 void		generic_error(const char *, ...);
 void		generic_end  (void);
 void		generic_usage(void);
@@ -167,6 +175,7 @@ void		generic_usage(void);
 ** miscellaneous prototypes
 */
 int		atopsar(int, char *[]);
+unsigned int	atopbench(int, char *[]);
 char   		*convtime(time_t, char *);
 char   		*convdate(time_t, char *);
 int   		getbranchtime(char *, time_t *);
@@ -208,10 +217,11 @@ int  		rawread(void);
 char		rawwrite (time_t, int,
 		            struct devtstat *, struct sstat *,
 			    struct cgchainer *, int, int,
-		            int, unsigned int, char);
+		            int, unsigned int, int);
 
 int 		numeric(char *);
 void		getalarm(int);
+void		setalarm(int);
 unsigned long long	getboot(void);
 char 		*getstrvers(void);
 unsigned short 	getnumvers(void);
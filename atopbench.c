@@ -0,0 +1,271 @@
+/*
+** ATOP - System & Process Monitor
+**
+** The program 'atop' offers the possibility to view the activity of
+** the system on system-level as well as process-level.
+**
+** This source-file contains the 'atopbench'-functionality, that makes
+** use of the 'atop'-framework to gather a number of samples back-to-back
+** (without waiting for an interval) and to report the number of samples
+** per second and the average costs per stage of gathering a sample.
+**
+** With the option -R the counters are gathered from the /proc and /sys
+** files below an alternate root directory, e.g. a synthetic tree created
+** by 'atopfixture', so collection optimizations can be measured
+** reproducibly and independent of the activity of the system.
+** ==========================================================================
+**
+** This program is free software; you can redistribute it and/or modify it
+** under the terms of the GNU General Public License as published by the
+** Free Software Foundation; either version 2, or (at your option) any
+** later version.
+**
+** This program is distributed in the hope that it will be useful, but
+** WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU General Public License for more details.
+** --------------------------------------------------------------------------
+*/
+
+#include <sys/types.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "atop.h"
+#include "photoproc.h"
+#include "photosyst.h"
+#include "statfile.h"
+#include "stagecost.h"
+
+static unsigned int	nwanted = 10;	/* number of measured samples	*/
+static unsigned int	nmeasured;	/* samples measured so far	*/
+static struct stgcost	total[NRSTAGES];/* accumulated costs per stage	*/
+static struct timespec	benchstart;	/* end of warm-up sample	*/
+static count_t		elapsed;	/* microseconds since warm-up	*/
+static unsigned long	ntasks, nprocs;
+static int		ncgroups;
+static unsigned long	rsswarm, rssmax, rsslast;	/* resident KiB	*/
+static struct pcachestat pcwarm, pclast;	/* procinfo cache	*/
+
+static char	benchsamp(time_t, int, struct devtstat *, struct sstat *,
+			struct cgchainer *, int, int, int, unsigned int, int);
+static void	benchreport(void);
+static unsigned long	getrss(void);
+static void	prbenchusage(char *);
+
+/*
+** interpret the command line arguments and install
+** the handler that accumulates the costs per sample
+**
+** return value: total number of samples to be taken
+**               (including the first sample that is used as warm-up)
+*/
+unsigned int
+atopbench(int argc, char *argv[])
+{
+	int	c;
+
+	while ((c = getopt(argc, argv, "?R:")) != EOF)
+	{
+		switch (c)
+		{
+		   case 'R':		/* alternate root directory */
+			/*
+			** the files below an alternate root directory are
+			** opened with root privileges as well, so a
+			** setuid-root atop may not accept one from the user
+			*/
+			if (rootprivs() && getuid() != 0)
+			{
+				fprintf(stderr, "flag -R not allowed "
+				                "for setuid-root atop\n");
+				exit(1);
+			}
+
+			sfsetroot(optarg);
+			break;
+
+		   default:
+			prbenchusage(argv[0]);
+		}
+	}
+
+	if (optind < argc)
+	{
+		if (!numeric(argv[optind]) || optind+1 < argc)
+			prbenchusage(argv[0]);
+
+		if ( (nwanted = atoi(argv[optind])) < 1)
+			prbenchusage(argv[0]);
+	}
+
+	/*
+	** every next sample is triggered immediately by the handler,
+	** so no timer is needed
+	*/
+	interval = 0;
+
+	handlers[numhandlers++].handle_sample = benchsamp;
+
+	return nwanted + 1;
+}
+
+/*
+** handler that is called after every sample instead of
+** the visualization functions
+*/
+static char
+benchsamp(time_t curtime, int nsecs,
+          struct devtstat *devtstat, struct sstat *sstat,
+          struct cgchainer *devchain, int ncgroup, int npids,
+          int nexit, unsigned int noverflow, int flag)
+{
+	struct timespec	now;
+	int		i;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	/*
+	** the first sample contains the one-time initializations,
+	** so it is only used as warm-up
+	*/
+	if (flag & RRBOOT)
+	{
+		rsswarm = rssmax = getrss();
+		getpcachestat(&pcwarm);
+		benchstart = now;
+		raise(SIGUSR1);		// trigger next sample
+		return '\0';
+	}
+
+	for (i=STGSYST; i <= STGDTSK; i++)
+	{
+		total[i].wallus += stagecost.stage[i].wallus;
+		total[i].cpuus  += stagecost.stage[i].cpuus;
+		total[i].nsysc  += stagecost.stage[i].nsysc;
+		total[i].nbytes += stagecost.stage[i].nbytes;
+	}
+
+	ntasks   = devtstat->ntaskall;
+	nprocs   = devtstat->nprocall;
+	ncgroups = ncgroup;
+
+	/*
+	** keep track of the resident size, to verify that it remains
+	** stable during long runs with a high process churn
+	*/
+	if ( (rsslast = getrss()) > rssmax)
+		rssmax = rsslast;
+
+	if (++nmeasured < nwanted)
+	{
+		raise(SIGUSR1);		// trigger next sample
+		return '\0';
+	}
+
+	/*
+	** last sample: report the results
+	*/
+	elapsed = (now.tv_sec  - benchstart.tv_sec)  * 1000000LL +
+	          (now.tv_nsec - benchstart.tv_nsec) / 1000;
+
+	getpcachestat(&pclast);
+
+	benchreport();
+
+	return '\0';
+}
+
+/*
+** report the number of samples per second and the
+** average costs per stage
+*/
+static void
+benchreport(void)
+{
+	struct stgcost	coll = {0, 0, 0, 0};
+	int		i;
+
+	printf("samples   %u (after one warm-up sample)\n", nmeasured);
+	printf("tasks     %lu (%lu processes), %d cgroups\n",
+					ntasks, nprocs, ncgroups);
+	printf("elapsed   %.3f s\n", elapsed / 1000000.0);
+	printf("rate      %.1f samples/s\n",
+		elapsed > 0 ? nmeasured * 1000000.0 / elapsed : 0.0);
+	printf("rss       %lu KiB after warm-up, %lu KiB maximum, "
+	       "%lu KiB at end\n", rsswarm, rssmax, rsslast);
+
+	/*
+	** hits and misses of the cache of command lines and utsnames
+	** (only when enabled with the atoprc keyword 'cacheprocinfo')
+	*/
+	if (pclast.hits + pclast.misses > pcwarm.hits + pcwarm.misses)
+		printf("procinfo  %lld cache hits/sample, "
+		       "%lld cache misses/sample\n",
+			(pclast.hits   - pcwarm.hits)   / nmeasured,
+			(pclast.misses - pcwarm.misses) / nmeasured);
+
+	printf("\n");
+	printf("stage   wall-us/sample   cpu-us/sample  syscalls/sample"
+	       "     bytes/sample\n");
+
+	for (i=STGSYST; i <= STGDTSK; i++)
+	{
+		printf("%-5s %16lld %15lld %16lld %16lld\n", stagenames[i],
+			total[i].wallus / nmeasured, total[i].cpuus  / nmeasured,
+			total[i].nsysc  / nmeasured, total[i].nbytes / nmeasured);
+
+		coll.wallus += total[i].wallus;
+		coll.cpuus  += total[i].cpuus;
+		coll.nsysc  += total[i].nsysc;
+		coll.nbytes += total[i].nbytes;
+	}
+
+	printf("%-5s %16lld %15lld %16lld %16lld\n", "total",
+			coll.wallus / nmeasured, coll.cpuus  / nmeasured,
+			coll.nsysc  / nmeasured, coll.nbytes / nmeasured);
+
+	fflush(stdout);
+}
+
+/*
+** obtain the resident size of this process in KiB
+*/
+static unsigned long
+getrss(void)
+{
+	unsigned long	size, resident = 0;
+	FILE		*fp;
+
+	if ( (fp = fopen("/proc/self/statm", "r")) )
+	{
+		if (fscanf(fp, "%lu %lu", &size, &resident) != 2)
+			resident = 0;
+
+		fclose(fp);
+	}
+
+	return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+static void
+prbenchusage(char *myname)
+{
+	printf("Usage: %s [-R rootdir] [samples]\n", myname);
+	printf("\n");
+	printf("\tGather the specified number of samples (default 10) "
+	       "back-to-back,\n");
+	printf("\tpreceded by one warm-up sample, and report the number "
+	       "of samples\n");
+	printf("\tper second and the average costs per stage.\n");
+	printf("\n");
+	printf("\t  -R  gather the counters from the /proc and /sys files "
+	       "below\n");
+	printf("\t      an alternate root directory (see atopfixture)\n");
+
+	exit(1);
+}
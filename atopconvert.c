@@ -98,6 +98,10 @@
 #include "prev/photoproc_212.h"
 #include "prev/cgroups_212.h"
 
+#include "prev/photosyst_213.h"
+#include "prev/photoproc_213.h"
+#include "prev/cgroups_213.h"
+
 
 void	justcopy(void *, void *, count_t, count_t);
 
@@ -732,10 +736,12 @@ struct sstat_29		sstat_29;
 struct sstat_210	sstat_210;
 struct sstat_211	sstat_211;
 struct sstat_212	sstat_212;
+struct sstat_213	sstat_213;
 struct sstat		sstat;
 
 struct cstat_211	cstat_211;
 struct cstat_212	cstat_212;
+struct cstat_213	cstat_213;
 struct cstat		cstat;
 
 struct tstat_20		tstat_20;
@@ -751,6 +757,7 @@ struct tstat_29		tstat_29;
 struct tstat_210	tstat_210;
 struct tstat_211	tstat_211;
 struct tstat_212	tstat_212;
+struct tstat_213	tstat_213;
 struct tstat		tstat;
 
 struct convertall {
@@ -1327,6 +1334,51 @@ struct convertall {
 		{sizeof(struct cgdsk_212),
 	              STROFFSET(&cstat_212.dsk,  &cstat_212),   justcopy},
 	},
+
+	{SETVERSION(2,13), // 2.12 --> 2.13
+		 sizeof(struct sstat_213),	&sstat_213,
+		 sizeof(struct tstat_213), 	NULL,
+		 sizeof(struct cstat_213),	&cstat_213,	NULL,
+
+		{sizeof(struct cpustat_213),  	&sstat_213.cpu,	   justcopy},
+		{sizeof(struct memstat_213),  	&sstat_213.mem,	   justcopy},
+		{sizeof(struct netstat_213),  	&sstat_213.net,	   justcopy},
+		{sizeof(struct intfstat_213), 	&sstat_213.intf,   justcopy},
+		{sizeof(struct dskstat_213),  	&sstat_213.dsk,	   justcopy},
+		{sizeof(struct nfsstat_213),  	&sstat_213.nfs,	   justcopy},
+		{sizeof(struct contstat_213), 	&sstat_213.cfs,	   justcopy},
+		{sizeof(struct wwwstat_213),  	&sstat_213.www,	   justcopy},
+		{sizeof(struct pressure_213),  	&sstat_213.psi,	   justcopy},
+		{sizeof(struct gpustat_213),  	&sstat_213.gpu,	   justcopy},
+		{sizeof(struct ifbstat_213),  	&sstat_213.ifb,	   justcopy},
+		{sizeof(struct memnuma_213), 	&sstat_213.memnuma, justcopy},
+		{sizeof(struct cpunuma_213),  	&sstat_213.cpunuma, justcopy},
+		{sizeof(struct llcstat_213),  	&sstat_213.llc,	   justcopy},
+
+		{sizeof(struct gen_213),
+			STROFFSET(&tstat_213.gen, &tstat_213),	justcopy},
+		{sizeof(struct cpu_213),
+			STROFFSET(&tstat_213.cpu, &tstat_213),	justcopy},
+		{sizeof(struct dsk_213),
+			STROFFSET(&tstat_213.dsk, &tstat_213),	justcopy},
+		{sizeof(struct mem_213),
+			STROFFSET(&tstat_213.mem, &tstat_213),	justcopy},
+		{sizeof(struct net_213),
+			STROFFSET(&tstat_213.net, &tstat_213),	justcopy},
+		{sizeof(struct gpu_213),
+			STROFFSET(&tstat_213.gpu, &tstat_213),	justcopy},
+
+		{sizeof(struct cggen_213),
+		      STROFFSET(&cstat_213.gen,  &cstat_213),   justcopy},
+		{sizeof(struct cgconf_213),
+		      STROFFSET(&cstat_213.conf, &cstat_213),   justcopy},
+		{sizeof(struct cgcpu_213),
+	              STROFFSET(&cstat_213.cpu,  &cstat_213),   justcopy},
+		{sizeof(struct cgmem_213),
+	              STROFFSET(&cstat_213.mem,  &cstat_213),   justcopy},
+		{sizeof(struct cgdsk_213),
+	              STROFFSET(&cstat_213.dsk,  &cstat_213),   justcopy},
+	},
 };
 
 int	numconvs = sizeof convs / sizeof(struct convertall);
@@ -1482,6 +1534,17 @@ main(int argc, char *argv[])
 		exit(11);
 	}
 
+	// packed system-level statistics (since 2.13) can only be
+	// read by atop itself
+	//
+	if (irh.sstatlen & PACKEDSSTAT)
+	{
+		fprintf(stderr,
+			"File %s contains packed statistics that "
+			"can not be converted\n", infile);
+		exit(11);
+	}
+
 	// various consistency checks for system stats, task stats and
 	// (in case of a version > 2.11) cgroup stats
 	//
@@ -1583,6 +1646,18 @@ convert_samples(int ifd, int ofd, struct rawheader *irh, int ivix, int ovix, int
 	{
 		count++;
 
+		// packed system-level statistics and a trailer with the
+		// stage costs (since 2.13) can only be read by atop itself
+		// and are only found in files of the latest version
+		//
+		if (irr.flags & (RRPACKSSTAT|RRSTAGECOST))
+		{
+			fprintf(stderr,
+				"Sample %llu contains packed statistics that "
+				"can not be converted\n", count);
+			exit(11);
+		}
+
 		// read compressed system-level statistics and decompress
 		//
 		if ( !getrawsstat(ifd, convs[ivix].sstat, convs[ivix].sstatlen, irr.scomplen) )
@@ -0,0 +1,625 @@
+/*
+** ATOP - System & Process Monitor
+**
+** The program 'atop' offers the possibility to view the activity of
+** the system on system-level as well as process-level.
+**
+** This program generates a synthetic /proc and /sys/fs/cgroup tree
+** below a root directory with a configurable number of processes,
+** threads per process, CPUs, cgroups, disks and interfaces. The contents of
+** the files are taken from templates that are captured from a template
+** directory (by default the /proc and /sys/fs/cgroup filesystems of the
+** running system), only modified where the identity of a process,
+** disk or interface is concerned.
+**
+** The generated tree can be used by 'atopbench' (option -R) to measure
+** the costs of gathering the counters reproducibly and independent of
+** the activity of the system on which the benchmark runs.
+** ==========================================================================
+**
+** This program is free software; you can redistribute it and/or modify it
+** under the terms of the GNU General Public License as published by the
+** Free Software Foundation; either version 2, or (at your option) any
+** later version.
+**
+** This program is distributed in the hope that it will be useful, but
+** WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU General Public License for more details.
+** --------------------------------------------------------------------------
+*/
+#define _GNU_SOURCE
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <getopt.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define	MAXTPL		65536		// maximum size of a template file
+#define	MAXFIELDS	64		// maximum fields in stat template
+
+/*
+** system-level files that are copied from the template directory
+** (relative to proc directory)
+*/
+static const char	*sysfiles[] = {
+	"stat", "loadavg", "cpuinfo", "vmstat", "meminfo", "buddyinfo",
+	"net/snmp", "net/snmp6", "net/sockstat",
+	"pressure/cpu", "pressure/memory", "pressure/io",
+};
+
+/*
+** cgroup-level files that are copied from the template cgroup,
+** with default contents when the template cgroup lacks such file
+** (e.g. cgroups version 1)
+*/
+#define	PRESSURE	"some avg10=0.00 avg60=0.00 avg300=0.00 total=1000\n" \
+			"full avg10=0.00 avg60=0.00 avg300=0.00 total=500\n"
+
+static struct {
+	const char	*name;
+	const char	*defcontents;
+} cgrfiles[] = {
+	{ "cpu.stat",		"usage_usec 100000\nuser_usec 60000\n"
+				"system_usec 40000\n"			},
+	{ "cpu.weight",		"100\n"				},
+	{ "cpu.max",		"max 100000\n"				},
+	{ "cpu.pressure",	PRESSURE				},
+	{ "memory.current",	"10485760\n"				},
+	{ "memory.stat",	"anon 4194304\nfile 6291456\nkernel 0\n"
+				"shmem 0\n"				},
+	{ "memory.max",		"max\n"					},
+	{ "memory.swap.max",	"max\n"					},
+	{ "memory.pressure",	PRESSURE				},
+	{ "io.stat",		"8:0 rbytes=40960 wbytes=81920 rios=10 "
+				"wios=20 dbytes=0 dios=0\n"		},
+	{ "io.bfq.weight",	"default 100\n"			},
+	{ "io.pressure",	PRESSURE				},
+};
+
+#define	NSYSFILES	(sizeof sysfiles / sizeof sysfiles[0])
+#define	NCGRFILES	(sizeof cgrfiles / sizeof cgrfiles[0])
+
+/*
+** captured templates of the files per task
+*/
+static char	*tplstat, *tplstatus, *tplio, *tplschedstat;
+static char	*tplcgr[NCGRFILES];
+
+static char	*readtpl(const char *, const char *);
+static void	writefile(const char *, const char *, size_t);
+static void	makedir(const char *);
+static void	makestat(const char *, const char *, int);
+static void	maketask(const char *, int, int, int, int);
+static void	prusage(char *);
+
+int
+main(int argc, char *argv[])
+{
+	int		c, i, j, pid, tid;
+	int		nprocs=100, nthreads=1, ncgroups=10, ndisks=4, nintfs=2;
+	int		ncpus=0;
+	char		*tpldir = "/proc", *tplcgroup = NULL, *rootdir;
+	char		path[PATH_MAX], tplpath[PATH_MAX], cgdir[1024];
+	char		buf[4096], *p;
+	FILE		*fp;
+
+	while ((c = getopt(argc, argv, "?hp:t:C:c:d:i:T:G:")) != EOF)
+	{
+		switch (c)
+		{
+		   case 'p':			// number of processes
+			nprocs = atoi(optarg);
+			break;
+
+		   case 't':			// number of threads per process
+			nthreads = atoi(optarg);
+			break;
+
+		   case 'C':			// number of CPUs
+			ncpus = atoi(optarg);
+			break;
+
+		   case 'c':			// number of cgroups
+			ncgroups = atoi(optarg);
+			break;
+
+		   case 'd':			// number of disks
+			ndisks = atoi(optarg);
+			break;
+
+		   case 'i':			// number of interfaces
+			nintfs = atoi(optarg);
+			break;
+
+		   case 'T':			// template proc directory
+			tpldir = optarg;
+			break;
+
+		   case 'G':			// template cgroup directory
+			tplcgroup = optarg;
+			break;
+
+		   default:
+			prusage(argv[0]);
+		}
+	}
+
+	if (optind != argc-1 || nprocs < 1 || nthreads < 1 ||
+	    ncpus < 0 || ncpus > 2048 ||
+	    ncgroups < 0 || ndisks < 0 || nintfs < 0 || ndisks > 1024)
+		prusage(argv[0]);
+
+	rootdir = argv[optind];
+
+	/*
+	** capture the templates of the files per task from the
+	** template directory 'self' (i.e. this program when
+	** the /proc filesystem is used)
+	*/
+	tplstat      = readtpl(tpldir, "self/stat");
+	tplstatus    = readtpl(tpldir, "self/status");
+	tplio        = readtpl(tpldir, "self/io");
+	tplschedstat = readtpl(tpldir, "self/schedstat");
+
+	if (!tplstat || !tplstatus)
+	{
+		fprintf(stderr, "%s: no task templates found\n", tpldir);
+		exit(1);
+	}
+
+	/*
+	** the template cgroup is by default the cgroup of this program
+	*/
+	if (!tplcgroup && (p = readtpl(tpldir, "self/cgroup")))
+	{
+		char	*q = strncmp(p, "0::", 3) == 0 ? p : strstr(p, "\n0::");
+
+		if (q)
+		{
+			q += *q == '\n' ? 4 : 3;
+			q[strcspn(q, "\n")] = '\0';
+			snprintf(tplpath, sizeof tplpath, "/sys/fs/cgroup%s", q);
+			tplcgroup = tplpath;
+		}
+
+		free(p);
+	}
+
+	for (i=0; i < NCGRFILES; i++)
+	{
+		if (!tplcgroup ||
+		    (tplcgr[i] = readtpl(tplcgroup, cgrfiles[i].name)) == NULL)
+			tplcgr[i] = strdup(cgrfiles[i].defcontents);
+	}
+
+	/*
+	** create the directory structure of the root
+	*/
+	makedir(rootdir);
+
+	snprintf(path, sizeof path, "%s/proc", rootdir);
+	makedir(path);
+
+	snprintf(path, sizeof path, "%s/proc/net", rootdir);
+	makedir(path);
+
+	snprintf(path, sizeof path, "%s/proc/pressure", rootdir);
+	makedir(path);
+
+	/*
+	** copy the system-level files
+	*/
+	for (i=0; i < NSYSFILES; i++)
+	{
+		if ( (p = readtpl(tpldir, sysfiles[i])) == NULL)
+			continue;
+
+		snprintf(path, sizeof path, "%s/proc/%s", rootdir, sysfiles[i]);
+
+		if (ncpus && strcmp(sysfiles[i], "stat") == 0)
+			makestat(path, p, ncpus);
+		else
+			writefile(path, p, strlen(p));
+
+		free(p);
+	}
+
+	/*
+	** generate the disk statistics (disks sda, sdb, ...)
+	*/
+	snprintf(path, sizeof path, "%s/proc/diskstats", rootdir);
+
+	if ( (fp = fopen(path, "w")) == NULL)
+	{
+		perror(path);
+		exit(2);
+	}
+
+	for (i=0; i < ndisks; i++)
+	{
+		if (i < 26)
+			snprintf(buf, sizeof buf, "sd%c", 'a'+i);
+		else if (i < 26*27)
+			snprintf(buf, sizeof buf, "sd%c%c",
+						'a'+i/26-1, 'a'+i%26);
+		else
+			snprintf(buf, sizeof buf, "sd%c%c%c",
+						'a'+(i-26)/676-1,
+						'a'+(i-26)/26%26, 'a'+i%26);
+
+		fprintf(fp, "%4d %7d %s %d %d %d %d %d %d %d %d "
+		            "0 %d %d 0 0 0 0 0 0\n",
+			8, i*16, buf,
+			1000+i, 10, 80000+i*8, 500,
+			2000+i, 20, 160000+i*8, 900, 1200, 1400);
+	}
+
+	fclose(fp);
+
+	/*
+	** generate the interface statistics (interfaces eth0, eth1, ...)
+	*/
+	snprintf(path, sizeof path, "%s/proc/net/dev", rootdir);
+
+	if ( (fp = fopen(path, "w")) == NULL)
+	{
+		perror(path);
+		exit(2);
+	}
+
+	fprintf(fp, "Inter-|   Receive                            "
+	            "                    |  Transmit\n");
+	fprintf(fp, " face |bytes    packets errs drop fifo frame "
+	            "compressed multicast|bytes    packets errs drop "
+	            "fifo colls carrier compressed\n");
+	fprintf(fp, "    lo: 1000 10 0 0 0 0 0 0 1000 10 0 0 0 0 0 0\n");
+
+	for (i=0; i < nintfs; i++)
+		fprintf(fp, "%6s%d: %d %d 0 0 0 0 0 0 %d %d 0 0 0 0 0 0\n",
+			"eth", i, 150000+i, 1000+i, 90000+i, 800+i);
+
+	fclose(fp);
+
+	/*
+	** generate the processes with their threads, where the process
+	** id's are chosen in such a way that the thread id's follow the
+	** process id (pid 1 is the first process)
+	*/
+	for (i=0, pid=1; i < nprocs; i++, pid += nthreads)
+	{
+		snprintf(path, sizeof path, "%s/proc/%d", rootdir, pid);
+
+		maketask(path, pid, pid, i ? 1 : 0, nthreads);
+
+		snprintf(path, sizeof path, "%s/proc/%d/cmdline", rootdir, pid);
+		j = snprintf(buf, sizeof buf, "fixture%c-n%c%d", 0, 0, i) + 1;
+		writefile(path, buf, j);
+
+		snprintf(path, sizeof path, "%s/proc/%d/cgroup", rootdir, pid);
+
+		if (ncgroups)
+			j = snprintf(buf, sizeof buf,
+				"0::/fixture.slice/cg%d\n", i % ncgroups);
+		else
+			j = snprintf(buf, sizeof buf, "0::/\n");
+
+		writefile(path, buf, j);
+
+		if (nthreads == 1)
+			continue;
+
+		snprintf(path, sizeof path, "%s/proc/%d/task", rootdir, pid);
+		makedir(path);
+
+		for (tid=pid; tid < pid+nthreads; tid++)
+		{
+			snprintf(path, sizeof path, "%s/proc/%d/task/%d",
+							rootdir, pid, tid);
+
+			maketask(path, tid, pid, i ? 1 : 0, nthreads);
+		}
+	}
+
+	/*
+	** generate the cgroups below one intermediate cgroup,
+	** with the processes spread over these cgroups
+	*/
+	snprintf(path, sizeof path, "%s/sys", rootdir);
+	makedir(path);
+
+	snprintf(path, sizeof path, "%s/sys/fs", rootdir);
+	makedir(path);
+
+	for (i=-2; i < ncgroups; i++)
+	{
+		switch (i)
+		{
+		   case -2:
+			snprintf(cgdir, sizeof cgdir, "%s/sys/fs/cgroup",
+							rootdir);
+			break;
+		   case -1:
+			snprintf(cgdir, sizeof cgdir,
+				"%s/sys/fs/cgroup/fixture.slice", rootdir);
+			break;
+		   default:
+			snprintf(cgdir, sizeof cgdir,
+				"%s/sys/fs/cgroup/fixture.slice/cg%d",
+							rootdir, i);
+		}
+
+		makedir(cgdir);
+
+		for (j=0; j < NCGRFILES; j++)
+		{
+			snprintf(path, sizeof path, "%s/%s", cgdir,
+							cgrfiles[j].name);
+			writefile(path, tplcgr[j], strlen(tplcgr[j]));
+		}
+
+		snprintf(path, sizeof path, "%s/cgroup.procs", cgdir);
+
+		if ( (fp = fopen(path, "w")) == NULL)
+		{
+			perror(path);
+			exit(2);
+		}
+
+		for (j=0, pid=1; j < nprocs; j++, pid += nthreads)
+		{
+			if ((i == -2 && ncgroups == 0) ||
+			    (i >= 0  && j % ncgroups == i))
+				fprintf(fp, "%d\n", pid);
+		}
+
+		fclose(fp);
+	}
+
+	printf("%s: %d processes with %d threads, %d cgroups, "
+	       "%d disks, %d interfaces\n",
+		rootdir, nprocs, nthreads, ncgroups, ndisks, nintfs);
+
+	if (ncpus)
+		printf("%s: %d CPUs\n", rootdir, ncpus);
+
+	return 0;
+}
+
+/*
+** generate the file 'stat' from the template with the given number
+** of CPUs, all with the counters of the first CPU in the template
+*/
+static void
+makestat(const char *path, const char *tpl, int ncpus)
+{
+	const char	*line, *next, *cpuline = NULL;
+	FILE		*fp;
+	int		i, len = 0;
+
+	if ( (fp = fopen(path, "w")) == NULL)
+	{
+		perror(path);
+		exit(2);
+	}
+
+	for (line=tpl; *line; line=next)
+	{
+		if ( (next = strchr(line, '\n')) )
+			next++;
+		else
+			next = line + strlen(line);
+
+		/*
+		** keep the total line ("cpu ") and the other lines,
+		** but replace the lines per CPU
+		*/
+		if (strncmp(line, "cpu", 3) != 0 || line[3] == ' ')
+		{
+			fwrite(line, 1, next-line, fp);
+			continue;
+		}
+
+		if (cpuline)		// first CPU line already found
+			continue;
+
+		cpuline = strchr(line, ' ');
+		len     = next - cpuline;
+
+		for (i=0; i < ncpus; i++)
+			fprintf(fp, "cpu%d%.*s", i, len, cpuline);
+	}
+
+	fclose(fp);
+}
+
+/*
+** generate the files of one task (process or thread)
+** from the captured templates
+*/
+static void
+maketask(const char *taskdir, int tid, int tgid, int ppid, int nthreads)
+{
+	char	path[PATH_MAX], buf[MAXTPL], *field[MAXFIELDS], *p, *q;
+	char	stat[MAXTPL];
+	int	nfields, len, i;
+
+	makedir(taskdir);
+
+	/*
+	** stat: "pid (comm) state ppid ... num_threads ..."
+	*/
+	if ( (p = strrchr(tplstat, ')')) == NULL)
+		return;
+
+	strncpy(stat, p+1, sizeof stat - 1);
+	stat[sizeof stat - 1] = '\0';
+
+	for (nfields=0, q=strtok(stat, " \n"); q && nfields < MAXFIELDS;
+						q=strtok(NULL, " \n"))
+		field[nfields++] = q;
+
+	if (nfields < 18)
+		return;
+
+	len = snprintf(buf, sizeof buf, "%d (fixture) %s %d", tid,
+						field[0], ppid);
+
+	for (i=2; i < nfields && len < sizeof buf; i++)
+	{
+		if (i == 17)	// number of threads
+			len += snprintf(buf+len, sizeof buf - len,
+							" %d", nthreads);
+		else
+			len += snprintf(buf+len, sizeof buf - len,
+							" %s", field[i]);
+	}
+
+	if (len < sizeof buf - 1)
+		buf[len++] = '\n';
+
+	snprintf(path, sizeof path, "%s/stat", taskdir);
+	writefile(path, buf, len);
+
+	/*
+	** status: lines concerning the identity are replaced
+	*/
+	for (len=0, p=tplstatus; *p && len < sizeof buf; p = q)
+	{
+		if ( (q = strchr(p, '\n')) )
+			q++;
+		else
+			q = p + strlen(p);
+
+		if (strncmp(p, "Name:", 5) == 0)
+			len += snprintf(buf+len, sizeof buf - len,
+						"Name:\tfixture\n");
+		else if (strncmp(p, "Tgid:", 5) == 0)
+			len += snprintf(buf+len, sizeof buf - len,
+						"Tgid:\t%d\n", tgid);
+		else if (strncmp(p, "Pid:", 4) == 0)
+			len += snprintf(buf+len, sizeof buf - len,
+						"Pid:\t%d\n", tid);
+		else if (strncmp(p, "PPid:", 5) == 0)
+			len += snprintf(buf+len, sizeof buf - len,
+						"PPid:\t%d\n", ppid);
+		else if (strncmp(p, "Threads:", 8) == 0)
+			len += snprintf(buf+len, sizeof buf - len,
+						"Threads:\t%d\n", nthreads);
+		else
+			len += snprintf(buf+len, sizeof buf - len,
+						"%.*s", (int)(q-p), p);
+	}
+
+	if (len > sizeof buf - 1)
+		len = sizeof buf - 1;
+
+	snprintf(path, sizeof path, "%s/status", taskdir);
+	writefile(path, buf, len);
+
+	/*
+	** io and schedstat: unmodified
+	*/
+	if (tplio)
+	{
+		snprintf(path, sizeof path, "%s/io", taskdir);
+		writefile(path, tplio, strlen(tplio));
+	}
+
+	if (tplschedstat)
+	{
+		snprintf(path, sizeof path, "%s/schedstat", taskdir);
+		writefile(path, tplschedstat, strlen(tplschedstat));
+	}
+}
+
+/*
+** capture the contents of a template file
+**
+** return value: malloc'ed null-terminated contents or NULL
+*/
+static char *
+readtpl(const char *dir, const char *name)
+{
+	char	path[PATH_MAX], *buf;
+	ssize_t	len;
+	int	fd;
+
+	snprintf(path, sizeof path, "%s/%s", dir, name);
+
+	if ( (fd = open(path, O_RDONLY)) == -1)
+		return NULL;
+
+	if ( (buf = malloc(MAXTPL)) == NULL)
+	{
+		perror("malloc");
+		exit(2);
+	}
+
+	len = read(fd, buf, MAXTPL-1);
+
+	close(fd);
+
+	if (len <= 0)
+	{
+		free(buf);
+		return NULL;
+	}
+
+	buf[len] = '\0';
+
+	return buf;
+}
+
+static void
+writefile(const char *path, const char *buf, size_t len)
+{
+	int	fd;
+
+	if ( (fd = open(path, O_WRONLY|O_CREAT|O_TRUNC, 0644)) == -1 ||
+	     write(fd, buf, len) != len)
+	{
+		perror(path);
+		exit(2);
+	}
+
+	close(fd);
+}
+
+static void
+makedir(const char *path)
+{
+	if (mkdir(path, 0755) == -1 && errno != EEXIST)
+	{
+		perror(path);
+		exit(2);
+	}
+}
+
+static void
+prusage(char *name)
+{
+	fprintf(stderr, "Usage: %s [-p procs] [-t threads] [-C cpus] "
+	                "[-c cgroups]\n\t\t[-d disks] [-i interfaces] "
+	                ""
+	                "[-T templateprocdir] [-G templatecgroupdir] "
+	                "rootdir\n", name);
+	fprintf(stderr, "\t-p  number of processes (default 100)\n");
+	fprintf(stderr, "\t-t  number of threads per process (default 1)\n");
+	fprintf(stderr, "\t-C  number of CPUs (default: as in template)\n");
+	fprintf(stderr, "\t-c  number of cgroups (default 10)\n");
+	fprintf(stderr, "\t-d  number of disks (default 4)\n");
+	fprintf(stderr, "\t-i  number of interfaces (default 2)\n");
+	fprintf(stderr, "\t-T  directory with system-level templates and "
+	                "task templates in\n\t    subdirectory 'self' "
+	                "(default /proc)\n");
+	fprintf(stderr, "\t-G  cgroup directory with cgroup templates "
+	                "(default: own cgroup)\n");
+	exit(1);
+}
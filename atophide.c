@@ -60,6 +60,7 @@
 #include "photosyst.h"
 #include "photoproc.h"
 #include "rawlog.h"
+#include "stagecost.h"
 
 // struct to register fakenames that are assigned
 // to the original names
@@ -79,7 +80,7 @@ static void	writeout(int, void *, int);
 static void	writesamp(int, struct rawrecord *,
 			void *, int, void *, int, int,
 			void *, int, void *, int);
-static int	getrawsstat(int, struct sstat *, int);
+static int	getrawsstat(int, struct sstat *, int, int, int);
 static int	getrawtstat(int, struct tstat *, int, int);
 
 static void	testcompval(int, char *);
@@ -279,9 +280,14 @@ main(int argc, char *argv[])
 
                 // read compressed system-level statistics and decompress
                 //
-                if ( !getrawsstat(ifd, &sstat, rr.scomplen) )
+                if ( !getrawsstat(ifd, &sstat, rr.scomplen,
+		                              (rr.flags & RRPACKSSTAT),
+		                              (rr.flags & RRSTAGECOST)) )
                         exit(7);
 
+		// written in full again, without costs per stage
+		rr.flags &= ~(RRPACKSSTAT|RRSTAGECOST);
+
                 // read compressed process-level statistics and decompress
                 //
                 tstatp = malloc(sizeof(struct tstat) * rr.ndeviat);
@@ -581,9 +587,9 @@ prusage(char *name)
 // Function to read the system-level statistics from the current offset
 //
 static int
-getrawsstat(int rawfd, struct sstat *sp, int complen)
+getrawsstat(int rawfd, struct sstat *sp, int complen, int packed, int costs)
 {
-	Byte		*compbuf;
+	Byte		*compbuf, *origbuf = (Byte *)sp;
 	unsigned long	uncomplen = sizeof(struct sstat);
 	int		rv;
 
@@ -599,12 +605,42 @@ getrawsstat(int rawfd, struct sstat *sp, int complen)
 		return 0;
 	}
 
-	rv = uncompress((Byte *)sp, &uncomplen, compbuf, complen);
+	// packed representation (only array entries in use) is
+	// decompressed in a separate buffer and unpacked afterwards
+	//
+	if (packed)
+	{
+		uncomplen = sizeof(struct sstat) + sizeof(struct stagecost);
+		origbuf   = malloc(uncomplen);
+
+		ptrverify(origbuf, "Malloc failed for unpacking sysstats\n");
+	}
+
+	rv = uncompress(origbuf, &uncomplen, compbuf, complen);
 
 	testcompval(rv, "uncompress");
 
 	free(compbuf);
 
+	if (packed)
+	{
+		// skip the costs of atop per stage behind the packed
+		// representation
+		//
+		if (costs && uncomplen >= sizeof(struct stagecost))
+			uncomplen -= sizeof(struct stagecost);
+
+		rv = unpacksstat((char *)origbuf, uncomplen, sp);
+
+		free(origbuf);
+
+		if (!rv)
+		{
+			fprintf(stderr, "Corrupt packed system-level statistics\n");
+			return 0;
+		}
+	}
+
 	return 1;
 }
 
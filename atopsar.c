@@ -115,7 +115,7 @@ static void	reportlive(time_t, int, struct sstat *);
 static char     reportraw (time_t, int,
                             struct devtstat *, struct sstat *,
 			    struct cgchainer *, int, int,
-                            int, unsigned int, char);
+                            int, unsigned int, int);
 
 static void	reportheader(struct utsname *, time_t);
 static time_t	daylimit(time_t);
@@ -451,7 +451,7 @@ engine(void)
 	sigaction(SIGALRM, &sigact, (struct sigaction *)0);
 
 	if (interval > 0)
-		alarm(interval);
+		getalarm(0);	/* start the timer */
 
 	/*
 	** print overall report header
@@ -728,7 +728,7 @@ static char
 reportraw(time_t curtime, int numsecs,
          	struct devtstat *devtstat, struct sstat *sstat,
 		struct cgchainer *devchain, int ncgroups, int npids,
-		int nexit, unsigned int noverflow, char flags)
+		int nexit, unsigned int noverflow, int flags)
 {
 	static char		firstcall = 1;
 	char			timebuf[16], datebuf[16];
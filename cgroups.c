@@ -48,6 +48,7 @@
 #include "photosyst.h"
 #include "photoproc.h"
 #include "showgeneric.h"
+#include "statfile.h"
 
 static void		cgcalcdeviate(void);
 
@@ -139,11 +140,12 @@ int
 cgroupv2support(void)
 {
 	FILE	*fp;
-	char	line[128];
+	char	line[128], rootpath[1024];
 
 	// check if this kernel offers cgroups version 2
 	//
-	if ( (fp = fopen("/proc/1/cgroup", "r")) )
+	if ( (fp = fopen(sfpath("/proc/1/cgroup", rootpath, sizeof rootpath),
+								"r")) )
 	{
 		while (fgets(line, sizeof line, fp))
 		{
@@ -167,7 +169,8 @@ cgroupv2support(void)
 void
 photocgroup(void)
 {
-	char		origdir[4096];
+	char		origdir[4096], rootpath[1024];
+	const char	*cgroupdir;
 
 	// wipe previous cgroup chain (not needed any more)
 	//
@@ -198,8 +201,10 @@ photocgroup(void)
 	if ( getcwd(origdir, sizeof origdir) == NULL)
 		mcleanstop(53, "failed to save current dir\n");
 
-	if ( chdir(CGROUPROOT) == -1)
-		mcleanstop(54, "failed to change to " CGROUPROOT "\n");
+	cgroupdir = sfpath(CGROUPROOT, rootpath, sizeof rootpath);
+
+	if ( chdir(cgroupdir) == -1)
+		mcleanstop(54, "failed to change to %s\n", cgroupdir);
 
 	// read all subdirectory names below the cgroup top directory
 	//
@@ -43,16 +43,35 @@
 #include <limits.h>
 #include <memory.h>
 #include <string.h>
+#include <stddef.h>
 
 #include "atop.h"
 #include "ifprop.h"
 #include "photoproc.h"
 #include "photosyst.h"
 
+/*
+** number of consecutive counters in a struct, from the
+** counter 'first' until the counter 'last' (inclusive)
+*/
+#define	NRCOUNTS(type, first, last)	\
+	((offsetof(type, last) - offsetof(type, first)) / sizeof(count_t) + 1)
+
 static 		void calcdiff(struct tstat *, const struct tstat *,
 		                              const struct tstat *,
 		                              char, count_t);
 static inline	count_t subcount(count_t, count_t);
+static inline	void subcounts(count_t *, const count_t *, const count_t *,
+		                                                    int);
+static		void *reusearray(void *, unsigned long *, unsigned long,
+		                                   size_t, const char *);
+
+/*
+** the arrays of the process-level deviations are kept from one
+** sample to the next, so the number of allocated elements is
+** remembered per array
+*/
+static unsigned long	taskallsize, procallsize, procactsize;
 
 /*
 ** calculate the process-activity during the last sample
@@ -61,11 +80,16 @@ void
 deviattask(struct tstat    *curtpres, unsigned long ntaskpres,
            struct tstat    *curpexit, unsigned long nprocexit,
   	   struct devtstat *devtstat,
-  	   struct sstat    *devsstat)
+  	   struct sstat    *devsstat,
+	   int             nsecs,
+	   int             pnsecs)
 {
 	register int		c, d, pall=0, pact=0;
 	register struct tstat	*curstat, *devstat, *thisproc;
-	struct tstat		prestat, *pprestat;
+	struct tstat		prestat;
+	const struct tstat	*pprestat;
+	static const struct tstat zerostat;	/* previous stats new task */
+	struct tstat		*taskall, **procall, **procactive;
 	struct pinfo		*pinfo;
 	count_t			totusedcpu;
 	char			hashtype = 'p';
@@ -78,6 +102,13 @@ deviattask(struct tstat    *curtpres, unsigned long ntaskpres,
 			  devsstat->cpu.all.wtime + devsstat->cpu.all.Itime +
 			  devsstat->cpu.all.Stime + devsstat->cpu.all.steal;
 
+	/*
+	** the process-level interval might cover several system-level
+	** intervals (when 'procinterval' is used)
+	*/
+	if (pnsecs > nsecs)
+		totusedcpu = totusedcpu * pnsecs / nsecs;
+
 	/*
 	** make new list of all tasks in the task-database;
 	** after handling all task, the left-overs are tasks
@@ -86,24 +117,23 @@ deviattask(struct tstat    *curtpres, unsigned long ntaskpres,
 	pdb_makeresidue();
 
 	/*
- 	** remove allocated lists of previous sample and initialize counters
+ 	** keep the allocated lists of previous sample and initialize counters
 	*/
-	free(devtstat->taskall);
-
-	free(devtstat->procall);
-
-	free(devtstat->procactive);
+	taskall    = devtstat->taskall;
+	procall    = devtstat->procall;
+	procactive = devtstat->procactive;
 
 	memset(devtstat, 0, sizeof *devtstat);
 
+	devtstat->pinterval = pnsecs;
+
 	/*
-	** create list for the sample deviations of all tasks
+	** (re)use list for the sample deviations of all tasks
 	*/
  	devtstat->ntaskall = ntaskpres + nprocexit;
-	devtstat->taskall  = malloc(devtstat->ntaskall * sizeof(struct tstat));
-
-	ptrverify(devtstat->taskall, "Malloc failed for %lu deviated tasks\n",
-                                  devtstat->ntaskall);
+	devtstat->taskall  = reusearray(taskall, &taskallsize,
+				devtstat->ntaskall, sizeof(struct tstat),
+				"deviated tasks");
 
 	/*
 	** calculate deviations per present task
@@ -192,8 +222,7 @@ deviattask(struct tstat    *curtpres, unsigned long ntaskpres,
 			** new task which must have been started during
 			** last interval
 			*/
-			memset(&prestat, 0, sizeof(prestat));
-			pprestat = &prestat;
+			pprestat = &zerostat;
 
 			curstat->gen.wasinactive = 0;
 			devtstat->ntaskactive++;
@@ -215,9 +244,7 @@ deviattask(struct tstat    *curtpres, unsigned long ntaskpres,
 			/*
 			** create new task struct
 			*/
-			pinfo = calloc(1, sizeof(struct pinfo));
-
-			ptrverify(pinfo, "Malloc failed for new pinfo\n");
+			pinfo = pdb_newtask();
 
 			pinfo->tstat = *curstat;
 
@@ -389,7 +416,8 @@ deviattask(struct tstat    *curtpres, unsigned long ntaskpres,
 		}
 
 		if (prestat.gen.pid > 0)
-			pdb_deltask(prestat.gen.pid, prestat.gen.isproc);
+			pdb_deltask(prestat.gen.pid, prestat.gen.isproc,
+							prestat.gen.btime);
 
 		d++;
 	}
@@ -400,18 +428,14 @@ deviattask(struct tstat    *curtpres, unsigned long ntaskpres,
 	pdb_cleanresidue();
 
 	/*
-	** create and fill other pointer lists
+	** (re)use and fill other pointer lists
 	*/
-	devtstat->procall    = malloc(devtstat->nprocall *
-						sizeof(struct tstat *));
-	devtstat->procactive = malloc(devtstat->nprocactive *
-						sizeof(struct tstat *));
-
-	ptrverify(devtstat->procall, "Malloc failed for %d processes\n",
-                                  devtstat->nprocall);
-
-	ptrverify(devtstat->procactive, "Malloc failed for %d active procs\n",
-                                  devtstat->nprocactive);
+	devtstat->procall    = reusearray(procall, &procallsize,
+				devtstat->nprocall, sizeof(struct tstat *),
+				"processes");
+	devtstat->procactive = reusearray(procactive, &procactsize,
+				devtstat->nprocactive, sizeof(struct tstat *),
+				"active procs");
 
         for (c=0, thisproc=devstat=devtstat->taskall; c < devtstat->ntaskall;
 								c++, devstat++)
@@ -426,6 +450,29 @@ deviattask(struct tstat    *curtpres, unsigned long ntaskpres,
         }
 }
 
+/*
+** provide an array for the given number of elements, reusing the
+** array of the previous sample; it is only reallocated when it is
+** too small, or when it is much too large after a peak in the number
+** of tasks (to release the memory)
+*/
+static void *
+reusearray(void *array, unsigned long *sizep, unsigned long nelem,
+                                    size_t elemsize, const char *what)
+{
+	if (array && nelem <= *sizep && (nelem + 16) * 4 > *sizep)
+		return array;
+
+	free(array);
+
+	*sizep = nelem + nelem / 4 + 16;	/* room to grow */
+	array  = calloc(*sizep, elemsize);
+
+	ptrverify(array, "Malloc failed for %lu %s\n", *sizep, what);
+
+	return array;
+}
+
 /*
 ** calculate the differences between the current sample and
 ** the previous sample for a task
@@ -468,6 +515,8 @@ calcdiff(struct tstat *devstat, const struct tstat *curstat,
 	devstat->mem.vmem   = curstat->mem.vmem;
 	devstat->mem.rmem   = curstat->mem.rmem;
 	devstat->mem.pmem   = curstat->mem.pmem;
+	devstat->mem.pmemage = curstat->mem.pmemage;
+	devstat->mem.pmemrss = curstat->mem.pmemrss;
 	devstat->mem.vdata  = curstat->mem.vdata;
 	devstat->mem.vstack = curstat->mem.vstack;
 	devstat->mem.vlibs  = curstat->mem.vlibs;
@@ -521,34 +570,16 @@ calcdiff(struct tstat *devstat, const struct tstat *curstat,
 	if (devstat->cpu.utime > totusedcpu)
 		devstat->cpu.utime = 1;
 
-	devstat->cpu.rundelay  =
-		subcount(curstat->cpu.rundelay, prestat->cpu.rundelay);
-
-	devstat->cpu.blkdelay  =
-		subcount(curstat->cpu.blkdelay, prestat->cpu.blkdelay);
-
-	if (curstat->cpu.nvcsw >= prestat->cpu.nvcsw)
-		devstat->cpu.nvcsw  =
-			subcount(curstat->cpu.nvcsw, prestat->cpu.nvcsw);
-	else
-		devstat->cpu.nvcsw = curstat->cpu.nvcsw;
+	/*
+	** the delay counters and the context switch counters (rundelay
+	** until nivcsw) and the disk counters (rio until cwsz) are
+	** consecutive
+	*/
+	subcounts(&devstat->cpu.rundelay, &curstat->cpu.rundelay,
+	          &prestat->cpu.rundelay, NRCOUNTS(struct cpu, rundelay, nivcsw));
 
-	if (curstat->cpu.nivcsw >= prestat->cpu.nivcsw)
-		devstat->cpu.nivcsw =
-			subcount(curstat->cpu.nivcsw, prestat->cpu.nivcsw);
-	else
-		devstat->cpu.nivcsw = curstat->cpu.nivcsw;
-
-	devstat->dsk.rio    =
-		subcount(curstat->dsk.rio, prestat->dsk.rio);
-	devstat->dsk.rsz    =
-		subcount(curstat->dsk.rsz, prestat->dsk.rsz);
-	devstat->dsk.wio    =
-		subcount(curstat->dsk.wio, prestat->dsk.wio);
-	devstat->dsk.wsz    =
-		subcount(curstat->dsk.wsz, prestat->dsk.wsz);
-	devstat->dsk.cwsz   =
-		subcount(curstat->dsk.cwsz, prestat->dsk.cwsz);
+	subcounts(&devstat->dsk.rio, &curstat->dsk.rio, &prestat->dsk.rio,
+					NRCOUNTS(struct dsk, rio, cwsz));
 
 	devstat->mem.vgrow  = curstat->mem.vmem   - prestat->mem.vmem;
 	devstat->mem.rgrow  = curstat->mem.rmem   - prestat->mem.rmem;
@@ -560,56 +591,11 @@ calcdiff(struct tstat *devstat, const struct tstat *curstat,
 
 	/*
  	** network counters: due to an unload/load of the netatop module,
-	** previous counters might be larger than the current
+	** previous counters might be larger than the current (in which
+	** case subcount() takes the current counter)
 	*/
-	if (curstat->net.tcpsnd >= prestat->net.tcpsnd)
-		devstat->net.tcpsnd =
-			subcount(curstat->net.tcpsnd, prestat->net.tcpsnd);
-	else
-		devstat->net.tcpsnd = curstat->net.tcpsnd;
-
-	if (curstat->net.tcpssz >= prestat->net.tcpssz)
-		devstat->net.tcpssz =
-			subcount(curstat->net.tcpssz, prestat->net.tcpssz);
-	else
-		devstat->net.tcpssz = curstat->net.tcpssz;
-
-	if (curstat->net.tcprcv >= prestat->net.tcprcv)
-		devstat->net.tcprcv =
-			subcount(curstat->net.tcprcv, prestat->net.tcprcv);
-	else
-		devstat->net.tcprcv = curstat->net.tcprcv;
-
-	if (curstat->net.tcprsz >= prestat->net.tcprsz)
-		devstat->net.tcprsz =
-			subcount(curstat->net.tcprsz, prestat->net.tcprsz);
-	else
-		devstat->net.tcprsz = curstat->net.tcprsz;
-
-	if (curstat->net.udpsnd >= prestat->net.udpsnd)
-		devstat->net.udpsnd =
-			subcount(curstat->net.udpsnd, prestat->net.udpsnd);
-	else
-		devstat->net.udpsnd = curstat->net.udpsnd;
-
-	if (curstat->net.udpssz >= prestat->net.udpssz)
-		devstat->net.udpssz =
-			subcount(curstat->net.udpssz, prestat->net.udpssz);
-	else
-		devstat->net.udpssz = curstat->net.udpssz;
-
-	if (curstat->net.udprcv >= prestat->net.udprcv)
-		devstat->net.udprcv =
-			subcount(curstat->net.udprcv, prestat->net.udprcv);
-	else
-		devstat->net.udprcv = curstat->net.udprcv;
-
-	if (curstat->net.udprsz >= prestat->net.udprsz)
-		devstat->net.udprsz =
-			subcount(curstat->net.udprsz, prestat->net.udprsz);
-	else
-		devstat->net.udprsz = curstat->net.udprsz;
-
+	subcounts(&devstat->net.tcpsnd, &curstat->net.tcpsnd,
+	          &prestat->net.tcpsnd, NRCOUNTS(struct net, tcpsnd, udprsz));
 
 	if (curstat->gpu.state)
 	{
@@ -634,49 +620,29 @@ deviatsyst(struct sstat *cur, struct sstat *pre, struct sstat *dev,
 	dev->cpu.csw       = subcount(cur->cpu.csw,    pre->cpu.csw);
 	dev->cpu.nprocs    = subcount(cur->cpu.nprocs, pre->cpu.nprocs);
 
-	dev->cpu.all.stime = subcount(cur->cpu.all.stime, pre->cpu.all.stime);
-	dev->cpu.all.utime = subcount(cur->cpu.all.utime, pre->cpu.all.utime);
-	dev->cpu.all.ntime = subcount(cur->cpu.all.ntime, pre->cpu.all.ntime);
-	dev->cpu.all.itime = subcount(cur->cpu.all.itime, pre->cpu.all.itime);
-	dev->cpu.all.wtime = subcount(cur->cpu.all.wtime, pre->cpu.all.wtime);
-	dev->cpu.all.Itime = subcount(cur->cpu.all.Itime, pre->cpu.all.Itime);
-	dev->cpu.all.Stime = subcount(cur->cpu.all.Stime, pre->cpu.all.Stime);
-
-	dev->cpu.all.steal = subcount(cur->cpu.all.steal, pre->cpu.all.steal);
-	dev->cpu.all.guest = subcount(cur->cpu.all.guest, pre->cpu.all.guest);
+	/*
+	** the time counters (stime until guest) and the perf
+	** counters (instr until stalled) are consecutive
+	*/
+	subcounts(&dev->cpu.all.stime, &cur->cpu.all.stime, &pre->cpu.all.stime,
+				NRCOUNTS(struct percpu, stime, guest));
 
-	dev->cpu.all.instr = subcount(cur->cpu.all.instr, pre->cpu.all.instr);
-	dev->cpu.all.cycle = subcount(cur->cpu.all.cycle, pre->cpu.all.cycle);
+	subcounts(&dev->cpu.all.instr, &cur->cpu.all.instr, &pre->cpu.all.instr,
+				NRCOUNTS(struct percpu, instr, stalled));
 
 	for (i=0; i < dev->cpu.nrcpu; i++)
 	{
 		count_t 	ticks;
 
 		dev->cpu.cpu[i].cpunr = cur->cpu.cpu[i].cpunr;
-		dev->cpu.cpu[i].stime = subcount(cur->cpu.cpu[i].stime,
-					         pre->cpu.cpu[i].stime);
-		dev->cpu.cpu[i].utime = subcount(cur->cpu.cpu[i].utime,
-				 	         pre->cpu.cpu[i].utime);
-		dev->cpu.cpu[i].ntime = subcount(cur->cpu.cpu[i].ntime,
-					         pre->cpu.cpu[i].ntime);
-		dev->cpu.cpu[i].itime = subcount(cur->cpu.cpu[i].itime,
-					         pre->cpu.cpu[i].itime);
-		dev->cpu.cpu[i].wtime = subcount(cur->cpu.cpu[i].wtime,
-					         pre->cpu.cpu[i].wtime);
-		dev->cpu.cpu[i].Itime = subcount(cur->cpu.cpu[i].Itime,
-					         pre->cpu.cpu[i].Itime);
-		dev->cpu.cpu[i].Stime = subcount(cur->cpu.cpu[i].Stime,
-					         pre->cpu.cpu[i].Stime);
-
-		dev->cpu.cpu[i].steal = subcount(cur->cpu.cpu[i].steal,
-					         pre->cpu.cpu[i].steal);
-		dev->cpu.cpu[i].guest = subcount(cur->cpu.cpu[i].guest,
-					         pre->cpu.cpu[i].guest);
-
-		dev->cpu.cpu[i].instr = subcount(cur->cpu.cpu[i].instr,
-					         pre->cpu.cpu[i].instr);
-		dev->cpu.cpu[i].cycle = subcount(cur->cpu.cpu[i].cycle,
-					         pre->cpu.cpu[i].cycle);
+
+		subcounts(&dev->cpu.cpu[i].stime, &cur->cpu.cpu[i].stime,
+		          &pre->cpu.cpu[i].stime,
+				NRCOUNTS(struct percpu, stime, guest));
+
+		subcounts(&dev->cpu.cpu[i].instr, &cur->cpu.cpu[i].instr,
+		          &pre->cpu.cpu[i].instr,
+				NRCOUNTS(struct percpu, instr, stalled));
 
 		ticks 		      = cur->cpu.cpu[i].freqcnt.ticks;
 
@@ -785,24 +751,10 @@ deviatsyst(struct sstat *cur, struct sstat *pre, struct sstat *dev,
 			dev->cpunuma.numa[i].nrcpu  = cur->cpunuma.numa[i].nrcpu;
 			dev->cpunuma.numa[i].numanr = cur->cpunuma.numa[i].numanr;
 
-			dev->cpunuma.numa[i].utime  = subcount(cur->cpunuma.numa[i].utime,
-								pre->cpunuma.numa[i].utime);
-			dev->cpunuma.numa[i].ntime  = subcount(cur->cpunuma.numa[i].ntime,
-								pre->cpunuma.numa[i].ntime);
-			dev->cpunuma.numa[i].stime  = subcount(cur->cpunuma.numa[i].stime,
-								pre->cpunuma.numa[i].stime);
-			dev->cpunuma.numa[i].itime  = subcount(cur->cpunuma.numa[i].itime,
-								pre->cpunuma.numa[i].itime);
-			dev->cpunuma.numa[i].wtime  = subcount(cur->cpunuma.numa[i].wtime,
-								pre->cpunuma.numa[i].wtime);
-			dev->cpunuma.numa[i].Itime  = subcount(cur->cpunuma.numa[i].Itime,
-								pre->cpunuma.numa[i].Itime);
-			dev->cpunuma.numa[i].Stime  = subcount(cur->cpunuma.numa[i].Stime,
-								pre->cpunuma.numa[i].Stime);
-			dev->cpunuma.numa[i].steal  = subcount(cur->cpunuma.numa[i].steal,
-								pre->cpunuma.numa[i].steal);
-			dev->cpunuma.numa[i].guest  = subcount(cur->cpunuma.numa[i].guest,
-								pre->cpunuma.numa[i].guest);
+			subcounts(&dev->cpunuma.numa[i].stime,
+			          &cur->cpunuma.numa[i].stime,
+			          &pre->cpunuma.numa[i].stime,
+				NRCOUNTS(struct cpupernuma, stime, guest));
 		}
 	}
 
@@ -967,39 +919,13 @@ deviatsyst(struct sstat *cur, struct sstat *pre, struct sstat *dev,
 		*/
 		strcpy(dev->intf.intf[i].name, cur->intf.intf[i].name);
 
-		dev->intf.intf[i].rbyte = subcount(cur->intf.intf[i].rbyte,
-           	                                   pre->intf.intf[j].rbyte);
-		dev->intf.intf[i].rpack = subcount(cur->intf.intf[i].rpack,
-		                                   pre->intf.intf[j].rpack);
-		dev->intf.intf[i].rerrs = subcount(cur->intf.intf[i].rerrs,
-		                                   pre->intf.intf[j].rerrs);
-		dev->intf.intf[i].rdrop = subcount(cur->intf.intf[i].rdrop,
-		                                   pre->intf.intf[j].rdrop);
-		dev->intf.intf[i].rfifo = subcount(cur->intf.intf[i].rfifo,
-		                                   pre->intf.intf[j].rfifo);
-		dev->intf.intf[i].rframe= subcount(cur->intf.intf[i].rframe,
-		                                   pre->intf.intf[j].rframe);
-		dev->intf.intf[i].rcompr= subcount(cur->intf.intf[i].rcompr,
-		                                   pre->intf.intf[j].rcompr);
-		dev->intf.intf[i].rmultic=subcount(cur->intf.intf[i].rmultic,
-		                                   pre->intf.intf[j].rmultic);
-
-		dev->intf.intf[i].sbyte = subcount(cur->intf.intf[i].sbyte,
-		                                   pre->intf.intf[j].sbyte);
-		dev->intf.intf[i].spack = subcount(cur->intf.intf[i].spack,
-		                                   pre->intf.intf[j].spack);
-		dev->intf.intf[i].serrs = subcount(cur->intf.intf[i].serrs,
-		                                   pre->intf.intf[j].serrs);
-		dev->intf.intf[i].sdrop = subcount(cur->intf.intf[i].sdrop,
-		                                   pre->intf.intf[j].sdrop);
-		dev->intf.intf[i].sfifo = subcount(cur->intf.intf[i].sfifo,
-		                                   pre->intf.intf[j].sfifo);
-		dev->intf.intf[i].scollis= subcount(cur->intf.intf[i].scollis,
-		                                   pre->intf.intf[j].scollis);
-		dev->intf.intf[i].scarrier= subcount(cur->intf.intf[i].scarrier,
-		                                   pre->intf.intf[j].scarrier);
-		dev->intf.intf[i].scompr= subcount(cur->intf.intf[i].scompr,
-		                                   pre->intf.intf[j].scompr);
+		subcounts(&dev->intf.intf[i].rbyte, &cur->intf.intf[i].rbyte,
+		          &pre->intf.intf[j].rbyte,
+				NRCOUNTS(struct perintf, rbyte, rmultic));
+
+		subcounts(&dev->intf.intf[i].sbyte, &cur->intf.intf[i].sbyte,
+		          &pre->intf.intf[j].sbyte,
+				NRCOUNTS(struct perintf, sbyte, scompr));
 
 		dev->intf.intf[i].type  	= cur->intf.intf[i].type;
 		dev->intf.intf[i].duplex	= cur->intf.intf[i].duplex;
@@ -1043,19 +969,11 @@ deviatsyst(struct sstat *cur, struct sstat *pre, struct sstat *dev,
 
 		strcpy(dev->dsk.dsk[i].name, cur->dsk.dsk[i].name);
 
-		dev->dsk.dsk[i].nread  = subcount(cur->dsk.dsk[i].nread,
-		                                  pre->dsk.dsk[j].nread);
-		dev->dsk.dsk[i].nrsect = subcount(cur->dsk.dsk[i].nrsect,
-		                                  pre->dsk.dsk[j].nrsect);
-		dev->dsk.dsk[i].nwrite = subcount(cur->dsk.dsk[i].nwrite,
-		                                  pre->dsk.dsk[j].nwrite);
-		dev->dsk.dsk[i].nwsect = subcount(cur->dsk.dsk[i].nwsect,
-		                                  pre->dsk.dsk[j].nwsect);
-		dev->dsk.dsk[i].inflight  = cur->dsk.dsk[i].inflight;
-		dev->dsk.dsk[i].io_ms  = subcount(cur->dsk.dsk[i].io_ms,
-		                                  pre->dsk.dsk[j].io_ms);
-		dev->dsk.dsk[i].avque  = subcount(cur->dsk.dsk[i].avque,
-		                                  pre->dsk.dsk[j].avque);
+		subcounts(&dev->dsk.dsk[i].nread, &cur->dsk.dsk[i].nread,
+		          &pre->dsk.dsk[j].nread,
+				NRCOUNTS(struct perdsk, nread, avque));
+
+		dev->dsk.dsk[i].inflight = cur->dsk.dsk[i].inflight;
 
 		if (cur->dsk.dsk[i].ndisc != -1)	// discards supported?
 		{
@@ -1113,18 +1031,9 @@ deviatsyst(struct sstat *cur, struct sstat *pre, struct sstat *dev,
 
 		strcpy(dev->dsk.mdd[i].name, cur->dsk.mdd[i].name);
 
-		dev->dsk.mdd[i].nread  = subcount(cur->dsk.mdd[i].nread,
-		                                  pre->dsk.mdd[j].nread);
-		dev->dsk.mdd[i].nrsect = subcount(cur->dsk.mdd[i].nrsect,
-		                                  pre->dsk.mdd[j].nrsect);
-		dev->dsk.mdd[i].nwrite = subcount(cur->dsk.mdd[i].nwrite,
-		                                  pre->dsk.mdd[j].nwrite);
-		dev->dsk.mdd[i].nwsect = subcount(cur->dsk.mdd[i].nwsect,
-		                                  pre->dsk.mdd[j].nwsect);
-		dev->dsk.mdd[i].io_ms  = subcount(cur->dsk.mdd[i].io_ms,
-		                                  pre->dsk.mdd[j].io_ms);
-		dev->dsk.mdd[i].avque  = subcount(cur->dsk.mdd[i].avque,
-		                                  pre->dsk.mdd[j].avque);
+		subcounts(&dev->dsk.mdd[i].nread, &cur->dsk.mdd[i].nread,
+		          &pre->dsk.mdd[j].nread,
+				NRCOUNTS(struct perdsk, nread, avque));
 
 		if (cur->dsk.mdd[i].ndisc != -1)	// discards supported?
 		{
@@ -1182,18 +1091,9 @@ deviatsyst(struct sstat *cur, struct sstat *pre, struct sstat *dev,
 
 		strcpy(dev->dsk.lvm[i].name, cur->dsk.lvm[i].name);
 
-		dev->dsk.lvm[i].nread  = subcount(cur->dsk.lvm[i].nread,
-		                                  pre->dsk.lvm[j].nread);
-		dev->dsk.lvm[i].nrsect = subcount(cur->dsk.lvm[i].nrsect,
-		                                  pre->dsk.lvm[j].nrsect);
-		dev->dsk.lvm[i].nwrite = subcount(cur->dsk.lvm[i].nwrite,
-		                                  pre->dsk.lvm[j].nwrite);
-		dev->dsk.lvm[i].nwsect = subcount(cur->dsk.lvm[i].nwsect,
-		                                  pre->dsk.lvm[j].nwsect);
-		dev->dsk.lvm[i].io_ms  = subcount(cur->dsk.lvm[i].io_ms,
-		                                  pre->dsk.lvm[j].io_ms);
-		dev->dsk.lvm[i].avque  = subcount(cur->dsk.lvm[i].avque,
-		                                  pre->dsk.lvm[j].avque);
+		subcounts(&dev->dsk.lvm[i].nread, &cur->dsk.lvm[i].nread,
+		          &pre->dsk.lvm[j].nread,
+				NRCOUNTS(struct perdsk, nread, avque));
 
 		if (cur->dsk.lvm[i].ndisc != -1)	// discards supported?
 		{
@@ -1805,6 +1705,19 @@ totalsyst(char category, struct sstat *new, struct sstat *tot)
 }
 
 
+/*
+** subtract an array of consecutive counters, with the same
+** result per counter as subcount()
+*/
+static inline void
+subcounts(count_t *dev, const count_t *cur, const count_t *pre, int n)
+{
+	int	i;
+
+	for (i=0; i < n; i++)
+		dev[i] = subcount(cur[i], pre[i]);
+}
+
 /*
 ** Generic function to subtract two counters taking into 
 ** account the possibility that the counter is invalid
@@ -513,7 +513,7 @@ draw_samp(time_t curtime, int nsecs, struct sstat *sstat,
 
 				if (!rawreadflag)
 				{
-					alarm(1);
+					setalarm(1);
 				}
 				else
 				{
@@ -544,7 +544,7 @@ draw_samp(time_t curtime, int nsecs, struct sstat *sstat,
 				interval = newinterval;
 
 			if (!paused)
-				alarm(1); // set short timer
+				setalarm(1); // set short timer
 
 			break;
 
@@ -569,7 +569,7 @@ draw_samp(time_t curtime, int nsecs, struct sstat *sstat,
 			wininit(sstat);
 
 			if (interval && !paused && !rawreadflag)
-				alarm(1); // force new sample
+				setalarm(1); // force new sample
 
 			if (twinpid)    // twin mode?
 			{
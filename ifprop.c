@@ -37,7 +37,10 @@
 #include <linux/sockios.h>
 #include <linux/if.h>
 #include <linux/in.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
 #include <dirent.h>
+#include <errno.h>
 
 typedef __u64	u64;
 typedef __u32	u32;
@@ -53,9 +56,12 @@ typedef __u8	u8;
 #include "atop.h"
 #include "ifprop.h"
 #include "photosyst.h"
+#include "statfile.h"
 
 static int		calcbucket(char *);
 static int		getphysprop(struct ifprop *);
+static void		fillifprop(struct ifprop *);
+static int		linkchanges(void);
 
 /*
 ** hash table for linked lists with *all* interfaces
@@ -79,6 +85,23 @@ static struct ifprop	*ifhash[NUMIFHASH];
 */
 #define REFRESHTIME	60		// seconds
 static time_t		lastrefreshed; 	// epoch
+static int		nrifprops;	// number of interfaces in ifhash
+
+/*
+** when a netlink socket can be opened to receive the link changes
+** (interfaces created, removed or modified), only the interfaces
+** that changed are refreshed; the complete refresh is only done
+** with a (much) longer interval, e.g. for the speed of wireless
+** interfaces
+*/
+#define LONGREFRESH	600		// seconds
+#define MAXLINKCHG	64		// max. changes for partial refresh
+
+static int		nlsock = -1;	// netlink socket for link changes
+static char		nlprobed;	// boolean: netlink socket tried
+static int		ioctlsock = -1;	// socket for ethtool/wireless ioctls
+static int		nlinkchg;	// number of changed interfaces
+static char		linkchg[MAXLINKCHG][IFNAMSIZ];
 
 /*
 ** function that searches for the properties of a particular interface;
@@ -125,19 +148,102 @@ void
 initifprop(void)
 {
 	FILE 		*fp;
-	char		*cp, linebuf[2048];
+	char		*cp, linebuf[2048], rootpath[1024];
 	struct ifprop	*ifp, *ifpsave = NULL;
 	int		bucket, nrinterfaces=0, nrphysical=0;
 
 	DIR		*dirp;
 	struct dirent	*dentry;
 
+	/*
+	** once open a netlink socket to be notified about link changes
+	*/
+	if (!nlprobed)
+	{
+		struct sockaddr_nl	nladdr;
+
+		nlprobed = 1;
+
+		if ( (nlsock = socket(AF_NETLINK,
+				SOCK_RAW|SOCK_NONBLOCK|SOCK_CLOEXEC,
+				NETLINK_ROUTE)) != -1)
+		{
+			memset(&nladdr, 0, sizeof nladdr);
+
+			nladdr.nl_family = AF_NETLINK;
+			nladdr.nl_groups = RTMGRP_LINK;
+
+			if (bind(nlsock, (struct sockaddr *)&nladdr,
+							sizeof nladdr) == -1)
+			{
+				close(nlsock);
+				nlsock = -1;
+			}
+		}
+	}
+
 	/*
 	** verify if the interface properties have to be refreshed
-	** at this moment already
+	** at this moment already; with netlink only the interfaces
+	** that changed are refreshed in the meantime
 	*/
-	if (time(0) < lastrefreshed + REFRESHTIME)
+	if (lastrefreshed && nlsock != -1)
+	{
+		if (time(0) < lastrefreshed + LONGREFRESH)
+		{
+			int	i;
+
+			if ( (i = linkchanges()) == 0)
+				return;		// nothing changed
+
+			/*
+			** refresh the changed interfaces only, unless
+			** too many changes or the maximum number of
+			** interfaces might be reached
+			*/
+			if (i > 0 && nrifprops + i < MAXINTF)
+			{
+				for (i=0; i < nlinkchg; i++)
+				{
+					bucket = calcbucket(linkchg[i]);
+
+					for (ifp=ifhash[bucket]; ifp; ifp=ifp->next)
+					{
+						if (strcmp(ifp->name, linkchg[i]) == EQ)
+							break;
+					}
+
+					if (!ifp)	// new interface
+					{
+						ifp = malloc(sizeof *ifp);
+
+						ptrverify(ifp, "Malloc failed for ifprop struct\n");
+
+						memset(ifp, 0, sizeof *ifp);
+						safe_strcpy(ifp->name, linkchg[i],
+							sizeof ifp->name);
+
+						ifp->next = ifhash[bucket];
+						ifhash[bucket] = ifp;
+
+						nrifprops++;
+					}
+
+					fillifprop(ifp);
+				}
+
+				return;
+			}
+		}
+		else
+		{
+			(void) linkchanges();	// discard pending changes
+		}
+	}
+	else if (time(0) < lastrefreshed + REFRESHTIME)
+	{
 		return;
+	}
 
 	/*
  	** when this function has been called before, first remove
@@ -161,7 +267,7 @@ initifprop(void)
 	** open /proc/net/dev and read all interface names to be able to
 	** setup new entries in the hash table
 	*/
-	if ( (fp = fopen("/proc/net/dev", "r")) == NULL)
+	if ( (fp = sfopen("/proc/net/dev")) == NULL)
 		return;
 
 	while ( fgets(linebuf, sizeof(linebuf), fp) != NULL)
@@ -197,13 +303,16 @@ initifprop(void)
 		nrinterfaces++;
 	}
 
+	nrifprops = nrinterfaces;
+
 	fclose(fp);
 
 	/*
 	** read /sys/devices/virtual/net/xxx to determine which
 	** interfaces are virtual (xxx is subdirectory name)
 	*/
-	if ( (dirp = opendir("/sys/devices/virtual/net")) )
+	if ( (dirp = opendir(sfpath("/sys/devices/virtual/net", rootpath,
+							sizeof rootpath))) )
 	{
 		while ( (dentry = readdir(dirp)) )
 		{
@@ -287,6 +396,112 @@ initifprop(void)
 	}
 }
 
+/*
+** (re)determine the type and properties of one interface that
+** has been created or changed after the last complete refresh;
+** an interface that has been removed is marked 'invalid'
+*/
+static void
+fillifprop(struct ifprop *ifp)
+{
+	char	path[128], rootpath[1024];
+
+	snprintf(path, sizeof path, "/sys/class/net/%s", ifp->name);
+
+	ifp->type       = 'i';	// initially 'invalid'
+	ifp->speed      = 0;
+	ifp->fullduplex = 0;
+
+	if ( access(sfpath(path, rootpath, sizeof rootpath), F_OK) == -1)
+		return;		// interface removed
+
+	snprintf(path, sizeof path, "/sys/devices/virtual/net/%s", ifp->name);
+
+	if ( access(sfpath(path, rootpath, sizeof rootpath), F_OK) == 0)
+		ifp->type = 'v'; // virtual interface
+	else
+		getphysprop(ifp);
+}
+
+/*
+** read all pending link change messages from the netlink socket
+** and store the names of the interfaces involved
+**
+** return value: number of changed interfaces,
+**               -1 when too many changes (complete refresh required)
+*/
+static int
+linkchanges(void)
+{
+	char			buf[8192];
+	struct nlmsghdr		*nlh;
+	struct ifinfomsg	*ifi;
+	struct rtattr		*rta;
+	ssize_t			len;
+	int			i, attrlen, overflow = 0;
+
+	nlinkchg = 0;
+
+	while ( (len = recv(nlsock, buf, sizeof buf, MSG_DONTWAIT)) != 0)
+	{
+		if (len == -1)
+		{
+			if (errno == EINTR)
+				continue;
+
+			if (errno == ENOBUFS)	// messages lost
+			{
+				overflow = 1;
+				continue;
+			}
+
+			break;			// no more messages
+		}
+
+		for (nlh = (struct nlmsghdr *)buf; NLMSG_OK(nlh, len);
+		     nlh = NLMSG_NEXT(nlh, len))
+		{
+			if (nlh->nlmsg_type != RTM_NEWLINK &&
+			    nlh->nlmsg_type != RTM_DELLINK)
+				continue;
+
+			ifi     = NLMSG_DATA(nlh);
+			attrlen = IFLA_PAYLOAD(nlh);
+
+			for (rta = IFLA_RTA(ifi); RTA_OK(rta, attrlen);
+			     rta = RTA_NEXT(rta, attrlen))
+			{
+				if (rta->rta_type != IFLA_IFNAME)
+					continue;
+
+				// already registered as changed?
+				for (i=0; i < nlinkchg; i++)
+				{
+					if (strcmp(linkchg[i], RTA_DATA(rta)) == EQ)
+						break;
+				}
+
+				if (i < nlinkchg)
+					break;
+
+				if (nlinkchg < MAXLINKCHG)
+				{
+					safe_strcpy(linkchg[nlinkchg++],
+						RTA_DATA(rta), IFNAMSIZ);
+				}
+				else
+				{
+					overflow = 1;
+				}
+
+				break;
+			}
+		}
+	}
+
+	return overflow ? -1 : nlinkchg;
+}
+
 static int
 calcbucket(char *p)
 {
@@ -321,8 +536,16 @@ getphysprop(struct ifprop *p)
 	unsigned char			duplex = 0, ethernet = 0;
 
 
-	if ( (sockfd = socket(AF_INET, SOCK_DGRAM, 0)) == -1)
-		return 0;
+	/*
+	** the socket for the ioctls is only opened once
+	*/
+	if (ioctlsock == -1)
+	{
+		if ( (ioctlsock = socket(AF_INET, SOCK_DGRAM|SOCK_CLOEXEC, 0)) == -1)
+			return 0;
+	}
+
+	sockfd = ioctlsock;
 
 	/*
 	** determine properties of ethernet interface
@@ -366,7 +589,6 @@ getphysprop(struct ifprop *p)
 
 			if ( ioctl(sockfd, SIOCETHTOOL, &ifreq) != 0 )
 			{
-				close(sockfd);
 				free(ethlink);
 				return 0;
 			}
@@ -437,7 +659,6 @@ getphysprop(struct ifprop *p)
 #ifdef ETHTOOL_GLINKSETTINGS
 	free(ethlink);
 #endif
-	close(sockfd);
 
 	return 1;
 }
@@ -51,6 +51,7 @@
 #include "photoproc.h"
 #include "cgroups.h"
 #include "json.h"
+#include "stagecost.h"
 
 #define LEN_HP_SIZE	64
 #define LINE_BUF_SIZE	1024
@@ -93,6 +94,8 @@ static void json_print_NUC(char *, struct sstat *, struct tstat *, int,
                                                    struct cgchainer *, int);
 static void json_print_LLC(char *, struct sstat *, struct tstat *, int,
                                                    struct cgchainer *, int);
+static void json_print_STG(char *, struct sstat *, struct tstat *, int,
+                                                   struct cgchainer *, int);
 
 static void json_print_CGR(char *, struct sstat *, struct tstat *, int,
                                                    struct cgchainer *, int);
@@ -118,40 +121,42 @@ struct labeldef {
 	char	*label;
 	short   valid;
 	short   cgroupref;
+	short   tasklevel;	// process-level or cgroup-level label
 	void	(*prifunc)(char *, struct sstat *,
 	                           struct tstat *, int,
                                    struct cgchainer *, int);
 };
 
 static struct labeldef	labeldef[] = {
-	{ "CPU",	0, 0,	json_print_CPU },
-	{ "cpu",	0, 0,	json_print_cpu },
-	{ "CPL",	0, 0,	json_print_CPL },
-	{ "GPU",	0, 0,	json_print_GPU },
-	{ "MEM",	0, 0,	json_print_MEM },
-	{ "SWP",	0, 0,	json_print_SWP },
-	{ "PAG",	0, 0,	json_print_PAG },
-	{ "PSI",	0, 0,	json_print_PSI },
-	{ "LVM",	0, 0,	json_print_LVM },
-	{ "MDD",	0, 0,	json_print_MDD },
-	{ "DSK",	0, 0,	json_print_DSK },
-	{ "NFM",	0, 0,	json_print_NFM },
-	{ "NFC",	0, 0,	json_print_NFC },
-	{ "NFS",	0, 0,	json_print_NFS },
-	{ "NET",	0, 0,	json_print_NET },
-	{ "IFB",	0, 0,	json_print_IFB },
-	{ "NUM",	0, 0,	json_print_NUM },
-	{ "NUC",	0, 0,	json_print_NUC },
-	{ "LLC",	0, 0,	json_print_LLC },
-
-	{ "CGR",	0, 0,	json_print_CGR },
-
-	{ "PRG",	0, 1,	json_print_PRG },
-	{ "PRC",	0, 1,	json_print_PRC },
-	{ "PRM",	0, 1,	json_print_PRM },
-	{ "PRD",	0, 0,	json_print_PRD },
-	{ "PRN",	0, 0,	json_print_PRN },
-	{ "PRE",	0, 0,	json_print_PRE },
+	{ "CPU",	0, 0, 0,	json_print_CPU },
+	{ "cpu",	0, 0, 0,	json_print_cpu },
+	{ "CPL",	0, 0, 0,	json_print_CPL },
+	{ "GPU",	0, 0, 0,	json_print_GPU },
+	{ "MEM",	0, 0, 0,	json_print_MEM },
+	{ "SWP",	0, 0, 0,	json_print_SWP },
+	{ "PAG",	0, 0, 0,	json_print_PAG },
+	{ "PSI",	0, 0, 0,	json_print_PSI },
+	{ "LVM",	0, 0, 0,	json_print_LVM },
+	{ "MDD",	0, 0, 0,	json_print_MDD },
+	{ "DSK",	0, 0, 0,	json_print_DSK },
+	{ "NFM",	0, 0, 0,	json_print_NFM },
+	{ "NFC",	0, 0, 0,	json_print_NFC },
+	{ "NFS",	0, 0, 0,	json_print_NFS },
+	{ "NET",	0, 0, 0,	json_print_NET },
+	{ "IFB",	0, 0, 0,	json_print_IFB },
+	{ "NUM",	0, 0, 0,	json_print_NUM },
+	{ "NUC",	0, 0, 0,	json_print_NUC },
+	{ "LLC",	0, 0, 0,	json_print_LLC },
+	{ "STG",	0, 0, 0,	json_print_STG },
+
+	{ "CGR",	0, 0, 1,	json_print_CGR },
+
+	{ "PRG",	0, 1, 1,	json_print_PRG },
+	{ "PRC",	0, 1, 1,	json_print_PRC },
+	{ "PRM",	0, 1, 1,	json_print_PRM },
+	{ "PRD",	0, 0, 1,	json_print_PRD },
+	{ "PRN",	0, 0, 1,	json_print_PRN },
+	{ "PRE",	0, 0, 1,	json_print_PRE },
 };
 
 static int numlabels = sizeof labeldef / sizeof(struct labeldef);
@@ -234,11 +239,12 @@ int jsondef(char *pd)
 char jsonout(time_t curtime, int numsecs,
          struct devtstat *devtstat, struct sstat *sstat,
 	 struct cgchainer *devchain, int ncgroups, int npids,
-         int nexit, unsigned int noverflow, char flag)
+         int nexit, unsigned int noverflow, int flag)
 {
 	register int	i, j, k, cgroupref_created = 0;
 	char		header[256];
 	struct tstat	*tmp = devtstat->taskall;
+	char		procsample = !(flag & RRNOPROC);
 
 	printf("{\"host\": \"%s\", "
 		"\"timestamp\": %ld, "
@@ -248,6 +254,20 @@ char jsonout(time_t curtime, int numsecs,
 		numsecs
 		);
 
+	/*
+	** process-level and cgroup-level counters might cover
+	** a longer interval (see 'procinterval')
+	*/
+	if (procsample && devtstat->pinterval != numsecs)
+		printf(", \"procelapsed\": %d", devtstat->pinterval);
+
+	/*
+	** delay between scheduled and actual start of the sample and
+	** time needed to gather the sample (milliseconds)
+	*/
+	printf(", \"sampdelay\": %u, \"sampcollect\": %u",
+		sampdelay, sampcollect);
+
 	/* Replace " with # in case json can not parse this out */
 	for (k = 0; k < devtstat->ntaskall; k++, tmp++) {
 		for (j = 0; (j < sizeof(tmp->gen.name)) && tmp->gen.name[j]; j++)
@@ -266,6 +286,14 @@ char jsonout(time_t curtime, int numsecs,
 		if (!labeldef[i].valid)
 			continue;
 
+		/*
+		** process-level and cgroup-level labels are only
+		** printed when these counters have been gathered
+		** during this sample (see 'procinterval')
+		*/
+		if (labeldef[i].tasklevel && !procsample)
+			continue;
+
 		/*
 		** when cgroup index is needed to map the tstat to a cgroup,
 		** once fill the tstat.gen.cgroupix variables
@@ -354,7 +382,10 @@ json_print_CPU(char *hp, struct sstat *ss,
 		"\"freq\": %lld, "
 		"\"freqperc\": %d, "
 		"\"instr\": %lld, "
-		"\"cycle\": %lld}",
+		"\"cycle\": %lld, "
+		"\"cachemiss\": %lld, "
+		"\"branchmiss\": %lld, "
+		"\"stalled\": %lld}",
 		hp,
 		hertz,
 		ss->cpu.nrcpu,
@@ -370,7 +401,10 @@ json_print_CPU(char *hp, struct sstat *ss,
 		freq,
 		freqperc,
 		ss->cpu.all.instr,
-		ss->cpu.all.cycle
+		ss->cpu.all.cycle,
+		ss->cpu.all.cachemiss,
+		ss->cpu.all.branchmiss,
+		ss->cpu.all.stalled
 		);
 }
 
@@ -411,7 +445,10 @@ json_print_cpu(char *hp, struct sstat *ss,
 			"\"freq\": %lld, "
 			"\"freqperc\": %d, "
 			"\"instr\": %lld, "
-			"\"cycle\": %lld}",
+			"\"cycle\": %lld, "
+			"\"cachemiss\": %lld, "
+			"\"branchmiss\": %lld, "
+			"\"stalled\": %lld}",
 			i,
 			ss->cpu.cpu[i].stime,
 			ss->cpu.cpu[i].utime,
@@ -425,7 +462,10 @@ json_print_cpu(char *hp, struct sstat *ss,
 			freq,
 			freqperc,
 			ss->cpu.cpu[i].instr,
-			ss->cpu.cpu[i].cycle);
+			ss->cpu.cpu[i].cycle,
+			ss->cpu.cpu[i].cachemiss,
+			ss->cpu.cpu[i].branchmiss,
+			ss->cpu.cpu[i].stalled);
 	}
 
 	printf("]");
@@ -1060,6 +1100,37 @@ json_print_LLC(char *hp, struct sstat *ss,
 	printf("]");
 }
 
+/*
+** costs of atop itself per stage
+*/
+static void
+json_print_STG(char *hp, struct sstat *ss,
+                         struct tstat *ps, int nact,
+			 struct cgchainer *cs, int ncgroups)
+{
+	register int i;
+
+        printf(", %s: [", hp);
+
+	for (i = 0; i < NRSTAGES; i++) {
+		if (i > 0) {
+			printf(", ");
+		}
+		printf("{\"stage\": \"%s\", "
+			"\"wallus\": %lld, "
+			"\"cpuus\": %lld, "
+			"\"nsysc\": %lld, "
+			"\"nbytes\": %lld}",
+			stagenames[i],
+			stagecost.stage[i].wallus,
+			stagecost.stage[i].cpuus,
+			stagecost.stage[i].nsysc,
+			stagecost.stage[i].nbytes);
+	}
+
+	printf("]");
+}
+
 /*
 ** print functions for cgroups-level statistics
 */
@@ -1379,6 +1450,7 @@ json_print_PRM(char *hp, struct sstat *ss,
 			"\"vlock\": %lld, "
 			"\"vswap\": %lld, "
 			"\"pmem\": %lld, "
+			"\"pmemage\": %lld, "
 			"\"cgroup\": \"%s\"}",
 			ps->gen.pid,
 			ps->gen.name,
@@ -1396,6 +1468,7 @@ json_print_PRM(char *hp, struct sstat *ss,
 			ps->mem.vswap,
 			ps->mem.pmem == (unsigned long long)-1LL ?
 			0:ps->mem.pmem,
+			ps->mem.pmemage,
 			cgrpath);
 
 		if (supportflags & CGROUPV2 && ps->gen.cgroupix != -1)
@@ -29,4 +29,4 @@ int 	jsondef(char *);
 char	jsonout(time_t, int,
                  struct devtstat *, struct sstat *,
 		 struct cgchainer *, int, int,
-                 int, unsigned int, char);
+                 int, unsigned int, int);
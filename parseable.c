@@ -33,12 +33,14 @@
 #include <string.h>
 #include <limits.h>
 #include <sys/utsname.h>
+#include <time.h>
 
 #include "atop.h"
 #include "photosyst.h"
 #include "photoproc.h"
 #include "cgroups.h"
 #include "parseable.h"
+#include "stagecost.h"
 
 void 	print_CPU(char *, struct sstat *, struct tstat *, int,
                                           struct cgchainer *, int);
@@ -78,6 +80,8 @@ void 	print_NUC(char *, struct sstat *, struct tstat *, int,
                                           struct cgchainer *, int);
 void 	print_LLC(char *, struct sstat *, struct tstat *, int,
                                           struct cgchainer *, int);
+void 	print_STG(char *, struct sstat *, struct tstat *, int,
+                                          struct cgchainer *, int);
 
 void 	print_CGR(char *, struct sstat *, struct tstat *, int,
                                           struct cgchainer *, int);
@@ -106,40 +110,42 @@ struct labeldef {
 	char	*label;
 	short	valid;
 	short	cgroupref;
+	short	tasklevel;	// process-level or cgroup-level label
 	void	(*prifunc)(char *, struct sstat *,
 			           struct tstat *, int,
                                    struct cgchainer *, int);
 };
 
 static struct labeldef	labeldef[] = {
-	{ "CPU",	0, 0,	print_CPU },
-	{ "cpu",	0, 0,	print_cpu },
-	{ "CPL",	0, 0,	print_CPL },
-	{ "GPU",	0, 0,	print_GPU },
-	{ "MEM",	0, 0,	print_MEM },
-	{ "SWP",	0, 0,	print_SWP },
-	{ "PAG",	0, 0,	print_PAG },
-	{ "PSI",	0, 0,	print_PSI },
-	{ "LVM",	0, 0,	print_LVM },
-	{ "MDD",	0, 0,	print_MDD },
-	{ "DSK",	0, 0,	print_DSK },
-	{ "NFM",	0, 0,	print_NFM },
-	{ "NFC",	0, 0,	print_NFC },
-	{ "NFS",	0, 0,	print_NFS },
-	{ "NET",	0, 0,	print_NET },
-	{ "IFB",	0, 0,	print_IFB },
-	{ "NUM",	0, 0,	print_NUM },
-	{ "NUC",	0, 0,	print_NUC },
-	{ "LLC",	0, 0,	print_LLC },
-
-	{ "CGR",	0, 0,	print_CGR },
-
-	{ "PRG",	0, 1,	print_PRG },
-	{ "PRC",	0, 1,	print_PRC },
-	{ "PRM",	0, 1,	print_PRM },
-	{ "PRD",	0, 0,	print_PRD },
-	{ "PRN",	0, 0,	print_PRN },
-	{ "PRE",	0, 0,	print_PRE },
+	{ "CPU",	0, 0, 0,	print_CPU },
+	{ "cpu",	0, 0, 0,	print_cpu },
+	{ "CPL",	0, 0, 0,	print_CPL },
+	{ "GPU",	0, 0, 0,	print_GPU },
+	{ "MEM",	0, 0, 0,	print_MEM },
+	{ "SWP",	0, 0, 0,	print_SWP },
+	{ "PAG",	0, 0, 0,	print_PAG },
+	{ "PSI",	0, 0, 0,	print_PSI },
+	{ "LVM",	0, 0, 0,	print_LVM },
+	{ "MDD",	0, 0, 0,	print_MDD },
+	{ "DSK",	0, 0, 0,	print_DSK },
+	{ "NFM",	0, 0, 0,	print_NFM },
+	{ "NFC",	0, 0, 0,	print_NFC },
+	{ "NFS",	0, 0, 0,	print_NFS },
+	{ "NET",	0, 0, 0,	print_NET },
+	{ "IFB",	0, 0, 0,	print_IFB },
+	{ "NUM",	0, 0, 0,	print_NUM },
+	{ "NUC",	0, 0, 0,	print_NUC },
+	{ "LLC",	0, 0, 0,	print_LLC },
+	{ "STG",	0, 0, 0,	print_STG },
+
+	{ "CGR",	0, 0, 1,	print_CGR },
+
+	{ "PRG",	0, 1, 1,	print_PRG },
+	{ "PRC",	0, 1, 1,	print_PRC },
+	{ "PRM",	0, 1, 1,	print_PRM },
+	{ "PRD",	0, 0, 1,	print_PRD },
+	{ "PRN",	0, 0, 1,	print_PRN },
+	{ "PRE",	0, 0, 1,	print_PRE },
 };
 
 static int	numlabels = sizeof labeldef/sizeof(struct labeldef);
@@ -224,10 +230,11 @@ char
 parseout(time_t curtime, int numsecs,
          struct devtstat *devtstat, struct sstat *sstat,
          struct cgchainer *devchain, int ncgroups, int npids,
-         int nexit, unsigned int noverflow, char flag)
+         int nexit, unsigned int noverflow, int flag)
 {
 	register int	i, cgroupref_created = 0;
 	char		datestr[32], timestr[32], header[256];
+	char		procsample = !(flag & RRNOPROC);
 
 	/*
 	** print reset-label for sample-values since boot
@@ -242,6 +249,14 @@ parseout(time_t curtime, int numsecs,
 	{
 		if (labeldef[i].valid)
 		{
+			/*
+			** process-level and cgroup-level labels are
+			** only printed when these counters have been
+			** gathered during this sample (see 'procinterval')
+			*/
+			if (labeldef[i].tasklevel && !procsample)
+				continue;
+
 			/*
 			** when cgroup index is needed to map the tstat to a cgroup,
 			** once fill the tstat.gen.cgroupix variables
@@ -263,7 +278,8 @@ parseout(time_t curtime, int numsecs,
 				labeldef[i].label,
 				utsname.nodename,
 				(long long)curtime,
-				datestr, timestr, numsecs);
+				datestr, timestr, labeldef[i].tasklevel ?
+					devtstat->pinterval : numsecs);
 
 			/*
 			** call a selected print function
@@ -340,7 +356,8 @@ print_CPU(char *hp, struct sstat *ss,
         	ss->cpu.all.cycle = 0;
 	}
 
-	printf("%s %u %lld %lld %lld %lld %lld %lld %lld %lld %lld %lld %lld %d %lld %lld\n",
+	printf("%s %u %lld %lld %lld %lld %lld %lld %lld %lld %lld %lld %lld %d %lld %lld "
+	       "%lld %lld %lld\n",
 			hp,
 			hertz,
 	        	ss->cpu.nrcpu,
@@ -356,7 +373,10 @@ print_CPU(char *hp, struct sstat *ss,
                         freq,
                         freqperc,
         		ss->cpu.all.instr,
-        		ss->cpu.all.cycle
+        		ss->cpu.all.cycle,
+        		ss->cpu.all.cachemiss,
+        		ss->cpu.all.branchmiss,
+        		ss->cpu.all.stalled
                         );
 }
 
@@ -381,7 +401,8 @@ print_cpu(char *hp, struct sstat *ss,
                 calc_freqscale(maxfreq, cnt, ticks, &freq, &freqperc);
 
 		printf("%s %u %d %lld %lld %lld "
-		       "%lld %lld %lld %lld %lld %lld %lld %d %lld %lld\n",
+		       "%lld %lld %lld %lld %lld %lld %lld %d %lld %lld "
+		       "%lld %lld %lld\n",
 			hp, hertz, i,
 	        	ss->cpu.cpu[i].stime,
         		ss->cpu.cpu[i].utime,
@@ -395,7 +416,10 @@ print_cpu(char *hp, struct sstat *ss,
                         freq,
                         freqperc,
         		ss->cpu.cpu[i].instr,
-        		ss->cpu.cpu[i].cycle
+        		ss->cpu.cpu[i].cycle,
+        		ss->cpu.cpu[i].cachemiss,
+        		ss->cpu.cpu[i].branchmiss,
+        		ss->cpu.cpu[i].stalled
 			);
 	}
 }
@@ -833,6 +857,28 @@ print_LLC(char *hp, struct sstat *ss,
 	}
 }
 
+/*
+** costs of atop itself per stage
+*/
+void
+print_STG(char *hp, struct sstat *ss,
+                    struct tstat *ps, int nact,
+                    struct cgchainer *devchain, int ncgroups)
+{
+	register int 	i;
+
+	for (i=0; i < NRSTAGES; i++)
+	{
+		printf(	"%s %s %lld %lld %lld %lld\n",
+			hp,
+			stagenames[i],
+			stagecost.stage[i].wallus,
+			stagecost.stage[i].cpuus,
+			stagecost.stage[i].nsysc,
+			stagecost.stage[i].nbytes);
+	}
+}
+
 /*
 ** print functions for cgroups-level statistics
 */
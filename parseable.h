@@ -32,6 +32,6 @@ int 	parsedef(char *);
 char	parseout(time_t, int,
 		struct devtstat *, struct sstat *,
 		struct cgchainer *, int, int,
-		int, unsigned int, char);
+		int, unsigned int, int);
 
 #endif
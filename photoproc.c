@@ -38,6 +38,7 @@
 #include <sys/types.h>
 #include <sys/param.h>
 #include <dirent.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <string.h>
 #include <unistd.h>
@@ -45,47 +46,316 @@
 #include <time.h>
 #include <stdlib.h>
 #include <regex.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sys/resource.h>
 #include <glib.h>
 
 #include "atop.h"
 #include "photoproc.h"
+#include "procparse.h"
 #include "netatop.h"
-
-#define	SCANSTAT 	"%c   %d   %*d  %*d  %*d %*d  "	\
-			"%*d  %lld %*d  %lld %*d %lld "	\
-			"%lld %*d  %*d  %d   %d  %*d  "	\
-			"%*d  %ld  %lld %lld %*d %*d  "	\
-			"%*d  %*d  %*d  %*d  %*d %*d  " \
-			"%*d  %*d  %*d  %*d  %*d %*d  "	\
-			"%d   %d   %d   %lld"
-
-static int	procstat(struct tstat *, unsigned long long, char);
-static int	procstatus(struct tstat *);
-static int	procio(struct tstat *);
-static void	proccmd(struct tstat *);
-static void	procsmaps(struct tstat *);
-static void	procwchan(struct tstat *);
-static count_t	procschedstat(struct tstat *);
+#include "statfile.h"
+
+struct taskref;
+
+static int	procstat(struct tstat *, struct taskref *,
+					unsigned long long, char);
+static int	procstatus(struct tstat *, struct taskref *);
+static int	procio(struct tstat *, struct taskref *, char);
+static void	proccmd(struct tstat *, int);
+static void	procsmaps(struct tstat *, int);
+static void	procwchan(struct tstat *, int);
+static count_t	procschedstat(struct tstat *, struct taskref *);
+static FILE	*fopenat(int, const char *);
+static ssize_t	readtask(struct taskref *, int, char *, size_t);
+static int	taskdir(struct taskref *);
 
 extern GHashTable *ghash_net;
 
 extern char	prependenv;
 extern regex_t  envregex;
 
+/*
+** administration of the processes (subdirectories of /proc)
+** that are found during the current sample
+**
+** the process-level counters are gathered in the slot itself,
+** while the threads of the process are gathered directly in the
+** final position in the task list (taskpos+1 onwards)
+*/
+struct procslot {
+	char		name[16];	/* name of /proc subdirectory	*/
+	char		valid;		/* process info gathered?	*/
+	char		thrlisted;	/* task subdirectory listed?	*/
+	int		*tids;		/* list of thread ids		*/
+	unsigned long	ntids;		/* number of thread ids		*/
+	unsigned long	firstthr;	/* index in thread slot list	*/
+	unsigned long	taskpos;	/* position in task list	*/
+	struct pinfo	*prev;		/* same process previous sample	*/
+	struct tstat	tstat;		/* process-level counters	*/
+};
+
+struct thrslot {
+	struct procslot	*proc;		/* owning process		*/
+	int		tid;		/* thread id			*/
+	char		valid;		/* thread info gathered?	*/
+};
+
+/*
+** state of the current sample, shared with the worker threads
+*/
+static struct procslot	*procslots;
+static unsigned long	 nprocslots, maxprocslots;
+
+static struct thrslot	*thrslots;
+static unsigned long	 nthrslots, maxthrslots;
+
+static struct tstat	*curtasklist;
+static unsigned long long bootepoch;
+static int		 procfd;
+static char		*smapsfile = "smaps";
+
+static void	gatherproc(unsigned long);
+static void	gatherthread(unsigned long);
+
+/*
+** pool of worker threads that gather the task-level counters in
+** parallel (atoprc keyword 'procthreads'); the main thread always
+** participates, so the pool contains procthreads-1 worker threads
+**
+** the pool is never used by a setuid-root atop (see readrc()), so the
+** worker threads do not depend on root privileges that are regained
+** and dropped again by other threads
+**
+** work is handed out in chunks of items via a shared counter that
+** is incremented atomically, so a thread that finishes early simply
+** claims the next unhandled chunk
+*/
+#define	MAXPROCTHREADS	64
+#define	PROCCHUNK	8	/* number of processes per claim	*/
+#define	THRCHUNK	32	/* number of threads   per claim	*/
+
+static struct {
+	pthread_mutex_t	lock;
+	pthread_cond_t	start;
+	pthread_cond_t	done;
+	unsigned long	generation;	/* incremented for every job	*/
+	int		nworkers;	/* number of worker threads	*/
+	int		nbusy;		/* workers still busy with job	*/
+
+	void		(*func)(unsigned long);
+	unsigned long	nitems;		/* number of items in job	*/
+	unsigned long	chunk;		/* number of items per claim	*/
+	unsigned long	nextitem;	/* next item to be claimed	*/
+} pool = {
+	.lock	= PTHREAD_MUTEX_INITIALIZER,
+	.start	= PTHREAD_COND_INITIALIZER,
+	.done	= PTHREAD_COND_INITIALIZER,
+};
+
+/*
+** cache of the descriptors of the files below /proc that are read
+** for every task during every sample (atoprc keyword 'procfdcache')
+**
+** for long-living tasks these files are opened only once and are
+** reread with pread() at offset 0 during the next samples;
+** the entry of a task is removed as soon as the task is removed
+** from the process database (see fdcache_evict())
+**
+** the number of cached descriptors is limited to three quarters
+** of the maximum number of open files for this process
+*/
+#define	TF_STAT		0
+#define	TF_STATUS	1
+#define	TF_IO		2
+#define	TF_SCHEDSTAT	3
+#define	TF_NUM		4
+
+static const char	*taskfiles[TF_NUM] = {
+				"stat", "status", "io", "schedstat"
+			};
+
+#define	NFDHASH		4096	/* MUST be a power of 2 !!!		*/
+
+struct taskfds {
+	struct taskfds	*next;		/* next in hash chain		*/
+	int		pid;		/* process id or thread id	*/
+	char		isproc;		/* process-level or thread	*/
+	time_t		btime;		/* start time of task		*/
+	int		fd[TF_NUM];	/* cached descriptors or -1	*/
+};
+
+static struct taskfds	*fdhash[NFDHASH];
+static pthread_mutex_t	 fdmutex = PTHREAD_MUTEX_INITIALIZER;
+static long		 fdcached, fdcachemax;
+static char		 procfdcache;
+
+static char		 usetaskstats;	/* atoprc keyword 'taskstats'	*/
+
+static char		 skipidlethr;	/* atoprc keyword 'skipidlethreads' */
+
+/*
+** the command line and the utsname of a process are taken from the
+** previous sample (atoprc keyword 'cacheprocinfo'), unless the process
+** issued an exec in the meantime (different command name)
+*/
+static char		 cacheprocinfo;
+static struct pcachestat pcache;
+
+/*
+** with a PSS budget (atoprc keyword 'pssbudget'), the PSS is only
+** refreshed for a limited number of processes per sample, while the
+** last known PSS is carried forward for the other processes
+*/
+static char	pssprevious;	/* PSS gathered during previous sample?	*/
+
+static void	psspass(void);
+static void	gatherpss(unsigned long);
+static int		 idlethread(struct tstat *);
+
+static void		 fdcache_init(void);
+static struct taskfds	*fdcache_get(int, char);
+static void		 fdcache_drop(struct taskfds *);
+static void		 fdcache_free(struct taskfds *);
+
+/*
+** reference to the /proc directory of one task (relative path),
+** that is only opened when a file below it has to be opened
+*/
+struct taskref {
+	const char	*path;		/* directory relative to /proc	*/
+	int		dirfd;		/* opened directory or -1	*/
+	struct taskfds	*tfds;		/* cached descriptors or NULL	*/
+};
+
+static void
+pooljob(void)
+{
+	unsigned long	i, first, last;
+
+	while ( (first = __atomic_fetch_add(&pool.nextitem, pool.chunk,
+					__ATOMIC_RELAXED)) < pool.nitems)
+	{
+		if ( (last = first + pool.chunk) > pool.nitems)
+			last = pool.nitems;
+
+		for (i=first; i < last; i++)
+			(pool.func)(i);
+	}
+}
+
+static void *
+poolworker(void *arg)
+{
+	unsigned long	mygeneration = 0;
+
+	while (1)
+	{
+		pthread_mutex_lock(&pool.lock);
+
+		while (pool.generation == mygeneration)
+			pthread_cond_wait(&pool.start, &pool.lock);
+
+		mygeneration = pool.generation;
+
+		pthread_mutex_unlock(&pool.lock);
+
+		pooljob();
+
+		pthread_mutex_lock(&pool.lock);
+
+		if (--pool.nbusy == 0)
+			pthread_cond_signal(&pool.done);
+
+		pthread_mutex_unlock(&pool.lock);
+	}
+
+	return NULL;
+}
+
+/*
+** call func for every item in the range 0 till nitems-1,
+** spread over all threads of the pool (including the caller)
+*/
+static void
+poolrun(void (*func)(unsigned long), unsigned long nitems,
+					unsigned long chunk)
+{
+	pthread_mutex_lock(&pool.lock);
+
+	pool.func	= func;
+	pool.nitems	= nitems;
+	pool.chunk	= chunk;
+	pool.nextitem	= 0;
+	pool.nbusy	= pool.nworkers;
+	pool.generation++;
+
+	pthread_cond_broadcast(&pool.start);
+	pthread_mutex_unlock(&pool.lock);
+
+	pooljob();
+
+	pthread_mutex_lock(&pool.lock);
 
+	while (pool.nbusy > 0)
+		pthread_cond_wait(&pool.done, &pool.lock);
+
+	pthread_mutex_unlock(&pool.lock);
+}
+
+/*
+** start the worker threads of the pool (once)
+*/
+static void
+poolinit(void)
+{
+	pthread_t	tid;
+	sigset_t	allsigs, oldsigs;
+	int		i;
+
+	if (procthreads > MAXPROCTHREADS)
+		procthreads = MAXPROCTHREADS;
+
+	/*
+	** signals should only be delivered to the main thread,
+	** so block them in the worker threads
+	*/
+	sigfillset(&allsigs);
+	pthread_sigmask(SIG_BLOCK, &allsigs, &oldsigs);
+
+	for (i=1; i < procthreads; i++)
+	{
+		if (pthread_create(&tid, NULL, poolworker, NULL) != 0)
+			break;
+
+		pthread_detach(tid);
+		pool.nworkers++;
+	}
+
+	pthread_sigmask(SIG_SETMASK, &oldsigs, NULL);
+}
+
+
+/*
+** gather the counters of all processes and threads in the task list
+** that is passed by reference; the task list is reused for every sample
+** and is only enlarged when the number of tasks exceeds its size, so
+** the administration of the tasks is read in one pass over /proc
+*/
 unsigned long
-photoproc(struct tstat *tasklist, int maxtask)
+photoproc(struct tstat **tasklistp, unsigned long *maxtaskp)
 {
-	static int			firstcall = 1;
-	static unsigned long long	bootepoch;
+	static int		firstcall = 1;
+	static DIR		*procdir;
 
-	register struct tstat	*curtask;
+	register struct tstat	*curtask, *tasklist;
+	register struct procslot *ps;
 
 	FILE		*fp;
-	DIR		*dirp;
 	struct dirent	*entp;
-	char		origdir[4096], dockstat=0;
-	unsigned long	tval=0;
+	char		dockstat=0, rootpath[1024];
+	unsigned long	i, j, tval=0, taskpos;
 
 	/*
 	** one-time initialization stuff
@@ -97,12 +367,23 @@ photoproc(struct tstat *tasklist, int maxtask)
 		*/
 		regainrootprivs();
 
-		if ( (fp = fopen("/proc/1/io", "r")) )
+		if ( (fp = fopen(sfpath("/proc/1/io", rootpath,
+						sizeof rootpath), "r")) )
 		{
 			supportflags |= IOSTAT;
 			fclose(fp);
 		}
 
+		/*
+		** check if this kernel offers the cheaper smaps_rollup
+		*/
+		if ( (fp = fopen(sfpath("/proc/1/smaps_rollup", rootpath,
+						sizeof rootpath), "r")) )
+		{
+			smapsfile = "smaps_rollup";
+			fclose(fp);
+		}
+
 		if (! droprootprivs())
 			mcleanstop(42, "failed to drop root privs\n");
 
@@ -111,6 +392,39 @@ photoproc(struct tstat *tasklist, int maxtask)
 		*/
 		bootepoch = getboot();
 
+		/*
+		** keep the /proc directory open during the lifetime
+		** of atop; all files below /proc are opened relative
+		** to this directory, so the current directory of
+		** atop is never changed
+		*/
+		if ( (procdir = opendir(sfpath("/proc", rootpath,
+						sizeof rootpath))) == NULL)
+			mcleanstop(54, "failed to open /proc\n");
+
+		procfd = dirfd(procdir);
+
+		/*
+		** start the threads that gather the task-level
+		** counters in parallel (if wanted)
+		*/
+		if (procthreads > 1)
+			poolinit();
+
+		/*
+		** determine the maximum number of descriptors that
+		** may be kept open by the descriptor cache (if wanted)
+		*/
+		if (procfdcache)
+			fdcache_init();
+
+		/*
+		** verify if the thread-level counters can be
+		** obtained via TASKSTATS (if wanted)
+		*/
+		if (usetaskstats)
+			usetaskstats = taskstats_probe();
+
 		firstcall = 0;
 	}
 
@@ -149,15 +463,9 @@ photoproc(struct tstat *tasklist, int maxtask)
 	/*
 	** read all subdirectory-names below the /proc directory
 	*/
-	if ( getcwd(origdir, sizeof origdir) == NULL)
-		mcleanstop(53, "failed to save current dir\n");
-
-	if ( chdir("/proc") == -1)
-		mcleanstop(54, "failed to change to /proc\n");
-
-	dirp = opendir(".");
+	rewinddir(procdir);
 
-	while ( (entp = readdir(dirp)) && tval < maxtask )
+	for (nprocslots=0; (entp = readdir(procdir)); )
 	{
 		/*
 		** skip non-numerical names
@@ -165,56 +473,138 @@ photoproc(struct tstat *tasklist, int maxtask)
 		if (!isdigit(entp->d_name[0]))
 			continue;
 
-		/*
-		** change to the process' subdirectory
-		*/
-		if ( chdir(entp->d_name) != 0 )
-			continue;
+		if (nprocslots == maxprocslots)
+		{
+			maxprocslots += 1024;
 
-		/*
- 		** gather process-level information
-		*/
-		curtask	= tasklist+tval;
+			procslots = realloc(procslots,
+				maxprocslots * sizeof(struct procslot));
+
+			ptrverify(procslots, "Malloc failed for %lu procslots\n",
+							maxprocslots);
+		}
+
+		ps = procslots + nprocslots++;
+
+		safe_strcpy(ps->name, entp->d_name, sizeof ps->name);
+	}
+
+	/*
+	** phase 1: gather process-level info and list the threads
+	**          of multi-threaded processes
+	*/
+	if (pool.nworkers)
+		poolrun(gatherproc, nprocslots, PROCCHUNK);
+	else
+		for (i=0; i < nprocslots; i++)
+			gatherproc(i);
+
+	/*
+	** determine the position of every process and its threads
+	** in the task list, and build the list of threads to be gathered
+	*/
+	for (i=0, taskpos=0, nthrslots=0; i < nprocslots; i++)
+	{
+		ps = procslots+i;
 
-		if ( !procstat(curtask, bootepoch, 1)) /* from /proc/pid/stat */
+		if (!ps->valid)
 		{
-			if ( chdir("..") == -1)
-				;
+			free(ps->tids);
+			ps->tids = NULL;
 			continue;
 		}
 
-		if ( !procstatus(curtask) )	/* from /proc/pid/status  */
+		ps->taskpos  = taskpos++;
+		ps->firstthr = nthrslots;
+
+		if (nthrslots + ps->ntids > maxthrslots)
 		{
-			if ( chdir("..") == -1)
-				;
-			continue;
+			maxthrslots = nthrslots + ps->ntids + 4096;
+
+			thrslots = realloc(thrslots,
+				maxthrslots * sizeof(struct thrslot));
+
+			ptrverify(thrslots, "Malloc failed for %lu thrslots\n",
+							maxthrslots);
 		}
 
-		if ( !procio(curtask) )		/* from /proc/pid/io      */
+		for (j=0; j < ps->ntids; j++, nthrslots++, taskpos++)
 		{
-			if ( chdir("..") == -1)
-				;
-			continue;
+			thrslots[nthrslots].proc  = ps;
+			thrslots[nthrslots].tid   = ps->tids[j];
+			thrslots[nthrslots].valid = 0;
 		}
 
-		procschedstat(curtask);			/* from /proc/pid/schedstat */
-		proccmd(curtask);			/* from /proc/pid/cmdline */
-		dockstat += getutsname(curtask);	/* retrieve container/pod name */
+		free(ps->tids);
+		ps->tids = NULL;
+	}
 
-		/*
-		** reading the smaps file for every process with every sample
-		** is a really 'expensive' from a CPU consumption point-of-view,
-		** so gathering this info is optional
-		*/
-		if (calcpss)
-			procsmaps(curtask);	/* from /proc/pid/smaps */
+	/*
+	** verify if the task list is large enough to contain all
+	** processes and threads (with some margin for growth)
+	*/
+	if (taskpos > *maxtaskp)
+	{
+		*maxtaskp  = taskpos + taskpos/8 + 64;
+		*tasklistp = realloc(*tasklistp,
+				*maxtaskp * sizeof(struct tstat));
 
-		/*
-		** determine thread's wchan, if wanted ('expensive' from
-		** a CPU consumption point-of-view)
-		*/
-                if (getwchan)
-                	procwchan(curtask);
+		ptrverify(*tasklistp, "Malloc failed for %lu tstats\n",
+							*maxtaskp);
+	}
+
+	curtasklist = tasklist = *tasklistp;
+
+	/*
+	** refresh the PSS of a limited number of processes
+	*/
+	if (calcpss && pssbudget)
+		psspass();
+
+	pssprevious = calcpss;
+
+	/*
+	** phase 2: gather thread-level info
+	**
+	** the root privileges that are needed for TASKSTATS and for the
+	** file io of the threads are regained once for all threads
+	** instead of per thread (every seteuid() is also propagated to
+	** all worker threads)
+	*/
+	regainrootprivs();
+
+	if (pool.nworkers)
+		poolrun(gatherthread, nthrslots, THRCHUNK);
+	else
+		for (i=0; i < nthrslots; i++)
+			gatherthread(i);
+
+	if (! droprootprivs())
+		mcleanstop(42, "failed to drop root privs\n");
+
+	/*
+	** phase 3: fill the task list in the order of the /proc directory,
+	**          totalize the thread values per process and add the
+	**          information that is gathered per process only once
+	*/
+	for (i=0; i < nprocslots; i++)
+	{
+		ps = procslots+i;
+
+		if (!ps->valid)
+			continue;
+
+		curtask  = tasklist+tval;
+		*curtask = ps->tstat;
+
+		if (ps->prev)		/* known from previous sample? */
+			strcpy(curtask->gen.utsname,
+					ps->prev->tstat.gen.utsname);
+		else
+			getutsname(curtask);	/* retrieve container/pod name */
+
+		if (curtask->gen.utsname[0])
+			dockstat = 1;
 
 		if (supportflags & NETATOPBPF) {
 			struct taskcount *tc = g_hash_table_lookup(ghash_net, &(curtask->gen.tgid));
@@ -239,12 +629,11 @@ photoproc(struct tstat *tasklist, int maxtask)
 
 		/*
  		** if needed (when number of threads is larger than 1):
-		**   read and fill new entries with thread-level info
+		**   totalize the thread-level info
 		*/
 		if (curtask->gen.nthr > 1)
 		{
-			DIR		*dirtask;
-			struct dirent	*tent;
+			unsigned long cur_nth = 0;
 
 			curtask->gen.nthrrun  = 0;
 			curtask->gen.nthrslpi = 0;
@@ -267,512 +656,928 @@ photoproc(struct tstat *tasklist, int maxtask)
 			curtask->cpu.nvcsw  = 0;
 			curtask->cpu.nivcsw = 0;
 
-			/*
-			** open underlying task directory
-			*/
-			if ( chdir("task") == 0 )
+			if (!ps->thrlisted)	/* task directory not read? */
+				continue;
+
+			for (j=0; j < ps->ntids; j++)
 			{
-				unsigned long cur_nth = 0;
+				struct tstat *curthr;
 
-				dirtask = opendir(".");
+				if (!thrslots[ps->firstthr+j].valid)
+					continue;
 
 				/*
-				** due to race condition, opendir() might
-				** have failed (leave task and process-level
-				** directories)
+				** move thread info to the next free
+				** position (threads that disappeared
+				** leave a gap)
 				*/
-				if( dirtask == NULL )
+				curthr = tasklist+tval;
+
+				if (curthr != tasklist+ps->taskpos+1+j)
+					*curthr = *(tasklist+ps->taskpos+1+j);
+
+				// totalize values of all threads
+				curtask->cpu.rundelay +=
+					curthr->cpu.rundelay;
+
+				curtask->cpu.blkdelay +=
+					curthr->cpu.blkdelay;
+
+				curtask->cpu.nvcsw +=
+					curthr->cpu.nvcsw;
+
+				curtask->cpu.nivcsw +=
+					curthr->cpu.nivcsw;
+
+				// continue gathering
+				strcpy(curthr->gen.utsname,
+					curtask->gen.utsname);
+
+				switch (curthr->gen.state)
 				{
-					if(chdir("../..") == -1)
-						;
-					continue;
+	   	   		   case 'R':
+					curtask->gen.nthrrun  += 1;
+					break;
+	   	   		   case 'S':
+					curtask->gen.nthrslpi += 1;
+					break;
+	   	   		   case 'D':
+					curtask->gen.nthrslpu += 1;
+					break;
+	   	   		   case 'I':
+					curtask->gen.nthridle += 1;
+					break;
 				}
 
-				while ((tent=readdir(dirtask)) && tval<maxtask)
+				// try to read network stats from netatop's module
+				if (!(supportflags & NETATOPBPF)) {
+					netatop_gettask(curthr->gen.pid, 't',
+									curthr);
+				}
+				// all stats read now
+				tval++;	    /* increment thread-level */
+				cur_nth++;  /* increment # threads    */
+			}
+
+			// calibrate number of threads
+			curtask->gen.nthr = cur_nth;
+		}
+	}
+
+	if (dockstat)
+		supportflags |= CONTAINERSTAT;
+	else
+		supportflags &= ~CONTAINERSTAT;
+
+	resetutsname();		// reassociate atop with own UTS namespace
+
+	return tval;
+}
+
+/*
+** gather the process-level info of one process slot
+** and list its threads (if multi-threaded)
+**
+** might be called in parallel by the worker threads
+*/
+static void
+gatherproc(unsigned long slotnr)
+{
+	struct procslot	*ps = procslots+slotnr;
+	struct tstat	*curtask = &ps->tstat;
+	struct taskref	tr = {ps->name, -1, NULL};
+	int		pidfd, taskfd;
+	DIR		*dirtask;
+	struct dirent	*tent;
+
+	ps->valid	= 0;
+	ps->thrlisted	= 0;
+	ps->tids	= NULL;
+	ps->ntids	= 0;
+	ps->prev	= NULL;
+
+	memset(curtask, 0, sizeof *curtask);
+
+	if (procfdcache)
+		tr.tfds = fdcache_get(atoi(ps->name), 1);
+
+	if ( !procstat(curtask, &tr, bootepoch, 1) ||  /* from /proc/pid/stat */
+	     !procstatus(curtask, &tr)             ||  /* from /proc/pid/status */
+	     !procio(curtask, &tr, 1)              ||  /* from /proc/pid/io   */
+	     (pidfd = taskdir(&tr)) == -1		)
+	{
+		if (tr.tfds)
+			fdcache_drop(tr.tfds);
+
+		if (tr.dirfd != -1)
+			close(tr.dirfd);
+		return;
+	}
+
+	if (tr.tfds)
+		tr.tfds->btime = curtask->gen.btime;
+
+	procschedstat(curtask, &tr);		/* from /proc/pid/schedstat */
+
+	/*
+	** take the command line from the previous sample (if wanted)
+	** or read it from /proc/pid/cmdline
+	*/
+	if (cacheprocinfo)
+	{
+		struct pinfo	*pinfo;
+
+		if (pdb_peektask(curtask->gen.pid, 1, curtask->gen.btime,
+							&pinfo)		&&
+		    strcmp(pinfo->tstat.gen.name, curtask->gen.name) == 0)
+		{
+			ps->prev = pinfo;
+			__atomic_fetch_add(&pcache.hits, 1, __ATOMIC_RELAXED);
+		}
+		else
+		{
+			__atomic_fetch_add(&pcache.misses, 1, __ATOMIC_RELAXED);
+		}
+	}
+
+	if (ps->prev)
+		strcpy(curtask->gen.cmdline, ps->prev->tstat.gen.cmdline);
+	else
+		proccmd(curtask, pidfd);
+
+	/*
+	** reading the smaps file for every process with every sample
+	** is a really 'expensive' from a CPU consumption point-of-view,
+	** so gathering this info is optional
+	*/
+	if (calcpss && !pssbudget)
+		procsmaps(curtask, pidfd);	/* from /proc/pid/smaps */
+
+	/*
+	** determine thread's wchan, if wanted ('expensive' from
+	** a CPU consumption point-of-view)
+	*/
+	if (getwchan)
+		procwchan(curtask, pidfd);
+
+	ps->valid = 1;
+
+	/*
+	** if needed (when number of threads is larger than 1):
+	**   list the thread ids in the underlying task directory
+	*/
+	if (curtask->gen.nthr > 1)
+	{
+		if ( (taskfd = openat(pidfd, "task",
+				O_RDONLY|O_DIRECTORY|O_CLOEXEC)) != -1)
+		{
+			unsigned long maxtids = curtask->gen.nthr + 16;
+
+			/*
+			** due to race condition, fdopendir() might
+			** have failed
+			*/
+			if ( (dirtask = fdopendir(taskfd)) == NULL )
+			{
+				close(taskfd);
+				close(pidfd);
+				return;
+			}
+
+			ps->tids = malloc(maxtids * sizeof(int));
+
+			ptrverify(ps->tids, "Malloc failed for %lu tids\n",
+								maxtids);
+
+			while ( (tent = readdir(dirtask)) )
+			{
+				if ( tent->d_name[0] == '.' )
+					continue;
+
+				if (ps->ntids == maxtids)
 				{
-					struct tstat *curthr = tasklist+tval;
+					maxtids *= 2;
 
-					/*
-					** change to the thread's subdirectory
-					*/
-					if ( tent->d_name[0] == '.'  ||
-					     chdir(tent->d_name) != 0 )
-						continue;
+					ps->tids = realloc(ps->tids,
+						maxtids * sizeof(int));
 
-					if ( !procstat(curthr, bootepoch, 0))
-					{
-						if ( chdir("..") == -1)
-							;
-						continue;
-					}
+					ptrverify(ps->tids,
+					    "Malloc failed for %lu tids\n",
+					    maxtids);
+				}
 
-					if ( !procstatus(curthr) )
-					{
-						if ( chdir("..") == -1)
-							;
-						continue;
-					}
+				ps->tids[ps->ntids++] = atoi(tent->d_name);
+			}
 
-					if ( !procio(curthr) )
-					{
-						if ( chdir("..") == -1)
-							;
-						continue;
-					}
+			closedir(dirtask);
+
+			ps->thrlisted = 1;
+		}
+	}
+
+	close(pidfd);	/* leave process-level directory */
+}
+
+/*
+** select the processes for which the PSS is refreshed during this sample
+** (at most 'pssbudget' processes) and carry forward the last known PSS
+** for the other processes
+**
+** processes without a known PSS come first, followed by the processes
+** with the largest change of resident memory since their last PSS
+** refresh and the processes with the oldest PSS value
+*/
+struct pssprio {
+	struct procslot	*ps;
+	count_t		known;		/* boolean: PSS known before	*/
+	count_t		rsschange;	/* rmem change since refresh	*/
+	count_t		age;		/* samples since refresh	*/
+};
 
-					/*
-					** determine thread's wchan, if wanted
- 					** ('expensive' from a CPU consumption
-					** point-of-view)
-					*/
-                			if (getwchan)
-                        			procwchan(curthr);
+static struct pssprio	*psslist;
+
+static int
+psscompar(const void *a, const void *b)
+{
+	const struct pssprio	*pa = a, *pb = b;
+
+	if (pa->known != pb->known)
+		return pa->known < pb->known ? -1 : 1;
+
+	if (pa->rsschange != pb->rsschange)
+		return pa->rsschange > pb->rsschange ? -1 : 1;
+
+	if (pa->age != pb->age)
+		return pa->age > pb->age ? -1 : 1;
+
+	return 0;
+}
+
+static void
+psspass(void)
+{
+	static unsigned long	maxpsslist;
+
+	struct procslot	*ps;
+	struct tstat	*curtask, *prev;
+	struct pinfo	*pinfo;
+	unsigned long	i, npss;
+
+	if (nprocslots > maxpsslist)
+	{
+		maxpsslist = nprocslots + 1024;
+		psslist    = realloc(psslist, maxpsslist * sizeof *psslist);
+
+		ptrverify(psslist, "Malloc failed for %lu pss entries\n",
+							maxpsslist);
+	}
+
+	for (i=0, npss=0; i < nprocslots; i++)
+	{
+		ps = procslots+i;
+
+		if (!ps->valid)
+			continue;
+
+		curtask = &ps->tstat;
+
+		/*
+		** processes without virtual memory (kernel threads)
+		** have no PSS
+		*/
+		if (curtask->mem.vmem == 0)
+		{
+			curtask->mem.pmem    = 0;
+			curtask->mem.pmemrss = 0;
+			curtask->mem.pmemage = 0;
+			continue;
+		}
+
+		psslist[npss].ps        = ps;
+		psslist[npss].known     = 0;
+		psslist[npss].rsschange = 0;
+		psslist[npss].age       = 0;
+
+		/*
+		** the PSS of the previous sample can only be used
+		** when the PSS was gathered during that sample
+		** (age -1 means that the PSS has not been gathered yet)
+		*/
+		if (pssprevious &&
+		    pdb_peektask(curtask->gen.pid, 1, curtask->gen.btime, &pinfo) &&
+		    pinfo->tstat.mem.pmemage != -1)
+		{
+			prev = &pinfo->tstat;
+
+			curtask->mem.pmem    = prev->mem.pmem;
+			curtask->mem.pmemrss = prev->mem.pmemrss;
+			curtask->mem.pmemage = prev->mem.pmemage + 1;
+
+			psslist[npss].known     = 1;
+			psslist[npss].rsschange =
+				curtask->mem.rmem > prev->mem.pmemrss ?
+				curtask->mem.rmem - prev->mem.pmemrss :
+				prev->mem.pmemrss - curtask->mem.rmem;
+			psslist[npss].age       = curtask->mem.pmemage;
+		}
+		else
+		{
+			curtask->mem.pmem    = -1;	/* unknown */
+			curtask->mem.pmemage = -1;
+		}
+
+		npss++;
+	}
+
+	qsort(psslist, npss, sizeof *psslist, psscompar);
+
+	if (npss > (unsigned long)pssbudget)
+		npss = pssbudget;
+
+	if (pool.nworkers)
+		poolrun(gatherpss, npss, 1);
+	else
+		for (i=0; i < npss; i++)
+			gatherpss(i);
+}
+
+/*
+** refresh the PSS of one selected process
+**
+** might be called in parallel by the worker threads
+*/
+static void
+gatherpss(unsigned long pssnr)
+{
+	struct procslot	*ps      = psslist[pssnr].ps;
+	struct tstat	*curtask = &ps->tstat;
+	int		pidfd;
+
+	if ( (pidfd = openat(procfd, ps->name,
+				O_RDONLY|O_DIRECTORY|O_CLOEXEC)) == -1)
+		return;
+
+	procsmaps(curtask, pidfd);
+
+	close(pidfd);
+
+	curtask->mem.pmemrss = curtask->mem.rmem;
+	curtask->mem.pmemage = 0;
+}
+
+/*
+** gather the thread-level info of one thread slot directly
+** in its position in the task list
+**
+** might be called in parallel by the worker threads
+*/
+static void
+gatherthread(unsigned long slotnr)
+{
+	struct thrslot	*ts = thrslots+slotnr;
+	struct procslot	*ps = ts->proc;
+	struct tstat	*curthr;
+	unsigned long	taskpos;
+	char		path[64];
+	struct taskref	tr = {path, -1, NULL};
+
+	taskpos = ps->taskpos + 1 + (slotnr - ps->firstthr);
+
+	curthr = curtasklist+taskpos;
+
+	memset(curthr, 0, sizeof *curthr);
+
+	/*
+	** the thread's subdirectory is only opened when
+	** a file has to be opened that is not cached
+	*/
+	snprintf(path, sizeof path, "%s/task/%d", ps->name, ts->tid);
+
+	if (procfdcache)
+		tr.tfds = fdcache_get(ts->tid, 0);
+
+	if ( !procstat(curthr, &tr, bootepoch, 0) ||
+	     !procstatus(curthr, &tr)               )
+	{
+		if (tr.tfds)
+			fdcache_drop(tr.tfds);
+
+		if (tr.dirfd != -1)
+			close(tr.dirfd);
+		return;
+	}
+
+	if (tr.tfds)
+		tr.tfds->btime = curthr->gen.btime;
+
+	/*
+	** fast path for idle threads (if wanted): when the counters of
+	** the stat and status files did not change since the previous
+	** sample, the counters of the files io and schedstat are taken
+	** from the previous sample
+	*/
+	if (skipidlethr && idlethread(curthr))
+	{
+		if (tr.dirfd != -1)
+			close(tr.dirfd);
+
+		ts->valid = 1;
+		return;
+	}
+
+	/*
+	** the disk transfers, context switches and run delay of the
+	** thread are obtained via TASKSTATS if possible, or otherwise
+	** from the files io and schedstat
+	*/
+	if (!usetaskstats || !taskstats_gettask(ts->tid, curthr))
+	{
+		procio(curthr, &tr, 0);
+		procschedstat(curthr, &tr);
+	}
+
+	/*
+	** determine thread's wchan, if wanted
+	** ('expensive' from a CPU consumption
+	** point-of-view)
+	*/
+	if (getwchan && taskdir(&tr) != -1)
+		procwchan(curthr, tr.dirfd);
+
+	if (tr.dirfd != -1)
+		close(tr.dirfd);	/* thread */
+
+	curthr->gen.nthr = 1;
+
+	ts->valid = 1;
+}
+
+/*
+** verify if the thread has been idle since the previous sample,
+** i.e. the counters in its stat and status file are equal to the
+** counters of the previous sample in the process database; a thread
+** that ran shorter than a clock tick is still recognized as active
+** by its context switches
+**
+** when idle, the counters that are otherwise gathered from the files
+** io and schedstat (or via TASKSTATS) and the wchan are taken over
+** from the previous sample, while all fresh values are kept
+**
+** might be called in parallel by the worker threads
+**
+** return value:
+**	1 - idle thread, tstat completely filled
+**	0 - active or new thread, other files have to be read
+*/
+static int
+idlethread(struct tstat *curthr)
+{
+	struct pinfo	*pinfo;
+	struct tstat	*prev;
 
-					// totalize values of all threads
-					curtask->cpu.rundelay +=
-						procschedstat(curthr);
+	if (!pdb_peektask(curthr->gen.pid, 0, curthr->gen.btime, &pinfo))
+		return 0;
 
-					curtask->cpu.blkdelay +=
-						curthr->cpu.blkdelay;
+	prev = &pinfo->tstat;
+
+	if (prev->cpu.utime    != curthr->cpu.utime    ||
+	    prev->cpu.stime    != curthr->cpu.stime    ||
+	    prev->cpu.nvcsw    != curthr->cpu.nvcsw    ||
+	    prev->cpu.nivcsw   != curthr->cpu.nivcsw   ||
+	    prev->gen.state    != curthr->gen.state    ||
+	    prev->mem.minflt   != curthr->mem.minflt   ||
+	    prev->mem.majflt   != curthr->mem.majflt   ||
+	    prev->cpu.curcpu   != curthr->cpu.curcpu   ||
+	    prev->cpu.blkdelay != curthr->cpu.blkdelay   )
+		return 0;
 
-					curtask->cpu.nvcsw +=
-						curthr->cpu.nvcsw;
+	curthr->dsk.rsz		= prev->dsk.rsz;
+	curthr->dsk.rio		= prev->dsk.rio;
+	curthr->dsk.wsz		= prev->dsk.wsz;
+	curthr->dsk.wio		= prev->dsk.wio;
+	curthr->dsk.cwsz	= prev->dsk.cwsz;
 
-					curtask->cpu.nivcsw +=
-						curthr->cpu.nivcsw;
+	curthr->cpu.rundelay	= prev->cpu.rundelay;
 
-					// continue gathering
-					strcpy(curthr->gen.utsname,
-						curtask->gen.utsname);
+	if (getwchan)
+		strcpy(curthr->cpu.wchan, prev->cpu.wchan);
 
-					switch (curthr->gen.state)
-					{
-	   		   		   case 'R':
-						curtask->gen.nthrrun  += 1;
-						break;
-	   		   		   case 'S':
-						curtask->gen.nthrslpi += 1;
-						break;
-	   		   		   case 'D':
-						curtask->gen.nthrslpu += 1;
-						break;
-	   		   		   case 'I':
-						curtask->gen.nthridle += 1;
-						break;
-					}
+	curthr->gen.nthr	= 1;
 
-					curthr->gen.nthr = 1;
+	return 1;
+}
 
-					// try to read network stats from netatop's module
-					if (!(supportflags & NETATOPBPF)) {
-						netatop_gettask(curthr->gen.pid, 't',
-										curthr);
-					}
-					// all stats read now
-					tval++;	    /* increment thread-level */
-					cur_nth++;  /* increment # threads    */
+/*
+** open a file below the task directory referred to by dirfd
+** as a stdio stream (the current directory is never used)
+*/
+static FILE *
+fopenat(int dirfd, const char *name)
+{
+	FILE	*fp;
+	int	fd;
 
-					if ( chdir("..") == -1)
-						; /* thread */
-				}
+	if ( (fd = openat(dirfd, name, O_RDONLY|O_CLOEXEC)) == -1)
+		return NULL;
 
-				closedir(dirtask);
-				if ( chdir("..") == -1)
-					; /* leave task */
+	if ( (fp = fdopen(fd, "r")) == NULL)
+		close(fd);
 
-				// calibrate number of threads
-				curtask->gen.nthr = cur_nth;
-			}
-		}
+	return fp;
+}
 
-		if ( chdir("..") == -1)
-			; /* leave process-level directry */
-	}
+/*
+** return the descriptor of the directory of the task,
+** which is opened when not opened yet
+*/
+static int
+taskdir(struct taskref *tr)
+{
+	if (tr->dirfd == -1)
+		tr->dirfd = openat(procfd, tr->path,
+					O_RDONLY|O_DIRECTORY|O_CLOEXEC);
+	return tr->dirfd;
+}
 
-	closedir(dirp);
+/*
+** read a file from offset 0 until end-of-file or until the buffer
+** is full (one byte is kept free for the null-byte)
+**
+** returns: number of bytes read or -1 when the file can not be read
+*/
+static ssize_t
+preadall(int fd, char *buf, size_t bufsize)
+{
+	ssize_t	nr;
+	size_t	total = 0;
 
-	if ( chdir(origdir) == -1)
-		mcleanstop(55, "cannot change to %s\n", origdir);
+	while (total < bufsize-1)
+	{
+		if ( (nr = pread(fd, buf+total, bufsize-total-1, total)) == -1)
+			return -1;
 
-	if (dockstat)
-		supportflags |= CONTAINERSTAT;
-	else
-		supportflags &= ~CONTAINERSTAT;
+		if (nr == 0)		// end-of-file
+			break;
 
-	resetutsname();		// reassociate atop with own UTS namespace
+		total += nr;
+	}
 
-	return tval;
+	return total;
 }
 
 /*
-** count number of tasks in the system, i.e.
-** the number of processes plus the total number of threads
+** read the contents of one of the files below the task directory
+** into the buffer of the caller, terminated by a null-byte
+**
+** the files below /proc normally deliver their complete contents
+** with one read() when the buffer is large enough, but the file is
+** read until end-of-file anyhow; a cached descriptor is reread at
+** offset 0 instead of being reopened
+**
+** returns: number of bytes read or -1 when the file can not be read
+**          (a value of bufsize-1 means that the contents might
+**          have been truncated)
 */
-#define	TPTOLERANCE	2
-
-unsigned long
-counttasks(void)
+static ssize_t
+readtask(struct taskref *tr, int file, char *buf, size_t bufsize)
 {
-	unsigned long	nrproc=0, nrthread=0;
-	char		linebuf[256];
-	FILE		*fp;
-	DIR             *dirp;
-	struct dirent   *entp;
-	char            origdir[1024];
+	struct taskfds	*tf = tr->tfds;
+	ssize_t		nr;
+	int		fd;
 
-	/*
-	** determine total number of threads
-	*/
-	if ( (fp = fopen("/proc/loadavg", "r")) != NULL)
+	if (tf && tf->fd[file] != -1)
 	{
-		if ( fgets(linebuf, sizeof(linebuf), fp) != NULL)
+		if ( (nr = preadall(tf->fd[file], buf, bufsize)) != -1)
 		{
-			if ( sscanf(linebuf, "%*f %*f %*f %*d/%lu", &nrthread) < 1)
-				mcleanstop(53, "wrong /proc/loadavg\n");
+			buf[nr] = '\0';
+			return nr;
 		}
-		else
-			mcleanstop(53, "unreadable /proc/loadavg\n");
-
-		fclose(fp);
-	}
-	else
-		mcleanstop(53, "can not open /proc/loadavg\n");
-
-
-	/*
-	** add total number of processes
-	*/
-	if ( getcwd(origdir, sizeof origdir) == NULL)
-		mcleanstop(53, "cannot determine cwd\n");
-
-	if ( chdir("/proc") == -1)
-		mcleanstop(53, "cannot change to /proc\n");
-
-	dirp = opendir(".");
 
-	while ( (entp = readdir(dirp)) )
-	{
 		/*
-		** count subdirectory names under /proc starting with a digit
+		** the task has vanished (or the access is not allowed
+		** any more): close the cached descriptor and open
+		** the file again
 		*/
-		if (isdigit(entp->d_name[0]))
-			nrproc++;
+		close(tf->fd[file]);
+		tf->fd[file] = -1;
+		__atomic_fetch_sub(&fdcached, 1, __ATOMIC_RELAXED);
 	}
 
-	closedir(dirp);
+	if (taskdir(tr) == -1)
+		return -1;
+
+	if ( (fd = openat(tr->dirfd, taskfiles[file], O_RDONLY|O_CLOEXEC)) == -1)
+		return -1;
 
-	if ( chdir(origdir) == -1)
-		mcleanstop(53, "cannot change to %s\n", origdir);
+	nr = preadall(fd, buf, bufsize);
 
 	/*
-	** In a normal situation the number of threads will be far more
-	** than the number of processes since every process consists of
-	** at least one thread (even zombie processes) while many processes
-	** consist of multiple threads. Some malicious kernel versions in
-	** the past did not provide correct information about the number of
-	** threads for which a sanity check was added at this point.
-	**
-	** However, in the early boot phase (when the atop daemon is started)
-	** only single-threaded processes might run. Since the gathering of
-	** the number of threads and the number of processes is not one atomic
-	** operation, the number of threads might be 1 or 2 less than the number
-	** of processes. This should not lead to a preliminary termination.
+	** keep the descriptor open when the task has an entry
+	** in the cache and the maximum has not been reached yet
 	*/
-	if (nrthread < nrproc)
+	if (nr != -1 && tf &&
+	    __atomic_add_fetch(&fdcached, 1, __ATOMIC_RELAXED) <= fdcachemax)
+	{
+		tf->fd[file] = fd;
+	}
+	else
 	{
-		if (nrproc - nrthread > TPTOLERANCE)
-			mcleanstop(53, "#threads (%ld) < #procs (%ld)\n",
-					nrthread, nrproc);
+		if (nr != -1 && tf)
+			__atomic_fetch_sub(&fdcached, 1, __ATOMIC_RELAXED);
 
-		nrthread = nrproc;	// correct number of threads
+		close(fd);
 	}
 
-	return nrproc + nrthread;
+	if (nr == -1)
+		return -1;
+
+	buf[nr] = '\0';
+
+	return nr;
 }
 
 /*
-** open file "stat" and obtain required info
+** determine the maximum number of descriptors in the cache;
+** the soft limit of open files is raised to the hard limit
 */
-static int
-procstat(struct tstat *curtask, unsigned long long bootepoch, char isproc)
+static void
+fdcache_init(void)
 {
-	FILE	*fp;
-	int	nr;
-	char	line[4096], *p, *cmdhead, *cmdtail;
+	struct rlimit	rlim;
 
-	if ( (fp = fopen("stat", "r")) == NULL)
-		return 0;
+	if (getrlimit(RLIMIT_NOFILE, &rlim) == -1)
+		return;
 
-	if ( (nr = fread(line, 1, sizeof line-1, fp)) == 0)
+	if (rlim.rlim_cur < rlim.rlim_max)
 	{
-		fclose(fp);
-		return 0;
-	}
+		rlim.rlim_cur = rlim.rlim_max;
 
-	line[nr] = '\0';	// terminate string
+		if (rlim.rlim_cur > 1024*1024)
+			rlim.rlim_cur = 1024*1024;
 
-	/*
-    	** fetch command name
-	*/
-	cmdhead = strchr (line, '(');
-	cmdtail = strrchr(line, ')');
-
-	if (!cmdhead || !cmdtail || cmdtail < cmdhead) // parsing failed?
-	{
-		fclose(fp);
-		return 0;
+		if (setrlimit(RLIMIT_NOFILE, &rlim) == -1)
+			(void) getrlimit(RLIMIT_NOFILE, &rlim);
 	}
 
-	if ( (nr = cmdtail-cmdhead-1) > PNAMLEN)
-		nr = PNAMLEN;
+	fdcachemax = rlim.rlim_cur - rlim.rlim_cur / 4;
+}
 
-	p = curtask->gen.name;
+/*
+** search the cache entry of a task and create it
+** when not found (as long as the cache is not full)
+**
+** might be called in parallel by the worker threads
+*/
+static struct taskfds *
+fdcache_get(int pid, char isproc)
+{
+	struct taskfds	*tf;
+	int		i;
 
-	memcpy(p, cmdhead+1, nr);
-	*(p+nr) = 0;
+	pthread_mutex_lock(&fdmutex);
 
-	while ( (p = strchr(p, '\n')) != NULL)
+	for (tf = fdhash[pid&(NFDHASH-1)]; tf; tf = tf->next)
 	{
-		*p = '?';
-		p++;
+		if (tf->pid == pid && tf->isproc == isproc)
+			break;
 	}
 
-	/*
-  	** fetch other values
-  	*/
-	curtask->gen.isproc  = isproc;
-	curtask->cpu.rtprio  = 0;
-	curtask->cpu.policy  = 0;
-	curtask->gen.excode  = 0;
-
-	sscanf(line, "%d", &(curtask->gen.pid));  /* fetch pid */
-
-	nr = sscanf(cmdtail+2, SCANSTAT,
-		&(curtask->gen.state), 	&(curtask->gen.ppid),
-		&(curtask->mem.minflt),	&(curtask->mem.majflt),
-		&(curtask->cpu.utime),	&(curtask->cpu.stime),
-		&(curtask->cpu.prio),	&(curtask->cpu.nice),
-		&(curtask->gen.btime),
-		&(curtask->mem.vmem),	&(curtask->mem.rmem),
-		&(curtask->cpu.curcpu),	&(curtask->cpu.rtprio),
-		&(curtask->cpu.policy), &(curtask->cpu.blkdelay));
-
-	if (nr < 12)		/* parsing failed? */
+	if (!tf && __atomic_load_n(&fdcached, __ATOMIC_RELAXED) < fdcachemax)
 	{
-		fclose(fp);
-		return 0;
-	}
+		tf = malloc(sizeof *tf);
 
-	/*
- 	** normalization
-	*/
-	curtask->gen.btime   = (curtask->gen.btime+bootepoch)/hertz;
-	curtask->cpu.prio   += 100; 	/* was subtracted by kernel */
-	curtask->mem.vmem   /= 1024;
-	curtask->mem.rmem   *= pagesize/1024;
+		ptrverify(tf, "Malloc failed for descriptor cache\n");
 
-	fclose(fp);
+		tf->pid    = pid;
+		tf->isproc = isproc;
+		tf->btime  = 0;
 
-	switch (curtask->gen.state)
-	{
-  	   case 'R':
-		curtask->gen.nthrrun  = 1;
-		break;
-  	   case 'S':
-		curtask->gen.nthrslpi = 1;
-		break;
-  	   case 'D':
-		curtask->gen.nthrslpu = 1;
-		break;
-	   case 'I':
-		curtask->gen.nthridle = 1;
-		break;
+		for (i=0; i < TF_NUM; i++)
+			tf->fd[i] = -1;
+
+		tf->next = fdhash[pid&(NFDHASH-1)];
+		fdhash[pid&(NFDHASH-1)] = tf;
 	}
 
-	return 1;
+	pthread_mutex_unlock(&fdmutex);
+
+	return tf;
 }
 
 /*
-** open file "status" and obtain required info
+** remove an entry from the cache and close its descriptors
 */
-static int
-procstatus(struct tstat *curtask)
+static void
+fdcache_drop(struct taskfds *tf)
 {
-	FILE	*fp;
-	char	line[4096];
-
-	if ( (fp = fopen("status", "r")) == NULL)
-		return 0;
+	struct taskfds	**tfp;
 
-	curtask->gen.nthr     = 1;	/* for compat with 2.4 */
-	curtask->cpu.sleepavg = 0;	/* for compat with 2.4 */
-	curtask->mem.vgrow    = 0;	/* calculated later */
-	curtask->mem.rgrow    = 0;	/* calculated later */
+	pthread_mutex_lock(&fdmutex);
 
-	while (fgets(line, sizeof line, fp))
+	for (tfp = &fdhash[tf->pid&(NFDHASH-1)]; *tfp; tfp = &(*tfp)->next)
 	{
-		if (memcmp(line, "Tgid:", 5) ==0)
+		if (*tfp == tf)
 		{
-			sscanf(line, "Tgid: %d", &(curtask->gen.tgid));
-			continue;
+			*tfp = tf->next;
+			break;
 		}
+	}
 
-		if (memcmp(line, "Pid:", 4) ==0)
-		{
-			sscanf(line, "Pid: %d", &(curtask->gen.pid));
-			continue;
-		}
+	pthread_mutex_unlock(&fdmutex);
 
-		if (memcmp(line, "SleepAVG:", 9)==0)
-		{
-			sscanf(line, "SleepAVG: %d%%",
-				&(curtask->cpu.sleepavg));
-			continue;
-		}
+	fdcache_free(tf);
+}
 
-		if (memcmp(line, "Uid:", 4)==0)
-		{
-			sscanf(line, "Uid: %d %d %d %d",
-				&(curtask->gen.ruid), &(curtask->gen.euid),
-				&(curtask->gen.suid), &(curtask->gen.fsuid));
-			continue;
-		}
+/*
+** close the descriptors of an entry that has been removed
+** from the cache and free the entry
+*/
+static void
+fdcache_free(struct taskfds *tf)
+{
+	int	i;
 
-		if (memcmp(line, "Gid:", 4)==0)
+	for (i=0; i < TF_NUM; i++)
+	{
+		if (tf->fd[i] != -1)
 		{
-			sscanf(line, "Gid: %d %d %d %d",
-				&(curtask->gen.rgid), &(curtask->gen.egid),
-				&(curtask->gen.sgid), &(curtask->gen.fsgid));
-			continue;
+			close(tf->fd[i]);
+			__atomic_fetch_sub(&fdcached, 1, __ATOMIC_RELAXED);
 		}
+	}
 
-		if (memcmp(line, "envID:", 6) ==0)
-		{
-			sscanf(line, "envID: %d", &(curtask->gen.ctid));
-			continue;
-		}
+	free(tf);
+}
 
-		if (memcmp(line, "VPid:", 5) ==0)
-		{
-			sscanf(line, "VPid: %d", &(curtask->gen.vpid));
-			continue;
-		}
+/*
+** remove the cache entry of a task that has been removed
+** from the process database; the start time is verified to
+** keep the entry of a new task that reuses the same pid
+*/
+void
+fdcache_evict(int pid, char isproc, time_t btime)
+{
+	struct taskfds	**tfp, *tf = NULL;
 
-		if (memcmp(line, "Threads:", 8)==0)
-		{
-			sscanf(line, "Threads: %d", &(curtask->gen.nthr));
-			continue;
-		}
+	if (!procfdcache)
+		return;
 
-		if (memcmp(line, "VmData:", 7)==0)
-		{
-			sscanf(line, "VmData: %lld", &(curtask->mem.vdata));
-			continue;
-		}
+	pthread_mutex_lock(&fdmutex);
 
-		if (memcmp(line, "VmStk:", 6)==0)
+	for (tfp = &fdhash[pid&(NFDHASH-1)]; *tfp; tfp = &(*tfp)->next)
+	{
+		if ((*tfp)->pid == pid && (*tfp)->isproc == isproc)
 		{
-			sscanf(line, "VmStk: %lld", &(curtask->mem.vstack));
-			continue;
+			if ((*tfp)->btime == btime)
+			{
+				tf   = *tfp;
+				*tfp = tf->next;
+			}
+			break;
 		}
+	}
 
-		if (memcmp(line, "VmExe:", 6)==0)
-		{
-			sscanf(line, "VmExe: %lld", &(curtask->mem.vexec));
-			continue;
-		}
+	pthread_mutex_unlock(&fdmutex);
 
-		if (memcmp(line, "VmLib:", 6)==0)
-		{
-			sscanf(line, "VmLib: %lld", &(curtask->mem.vlibs));
-			continue;
-		}
+	if (tf)
+		fdcache_free(tf);
+}
 
-		if (memcmp(line, "VmSwap:", 7)==0)
-		{
-			sscanf(line, "VmSwap: %lld", &(curtask->mem.vswap));
-			continue;
-		}
+/*
+** handle the atoprc keyword 'taskstats'
+*/
+void
+do_taskstats(char *tagname, char *tagvalue)
+{
+	if (strcmp(tagvalue, "enable") == 0)
+		usetaskstats = 1;
+	else if (strcmp(tagvalue, "disable") == 0)
+		usetaskstats = 0;
+	else
+		mcleanstop(1, "atoprc - %s: value 'enable' or 'disable' expected\n",
+								tagname);
+}
 
-		if (memcmp(line, "VmLck:", 6)==0)
-		{
-			sscanf(line, "VmLck: %lld", &(curtask->mem.vlock));
-			continue;
-		}
+/*
+** obtain the cumulative number of hits and misses of the cache of
+** command lines and utsnames (atoprc keyword 'cacheprocinfo')
+*/
+void
+getpcachestat(struct pcachestat *pcs)
+{
+	*pcs = pcache;
+}
 
-		if (memcmp(line, "voluntary_ctxt_switches:", 24)==0)
-		{
-			sscanf(line, "voluntary_ctxt_switches: %lld", &(curtask->cpu.nvcsw));
-			continue;
-		}
+/*
+** handle the atoprc keyword 'cacheprocinfo'
+*/
+void
+do_cacheprocinfo(char *tagname, char *tagvalue)
+{
+	if (strcmp(tagvalue, "enable") == 0)
+		cacheprocinfo = 1;
+	else if (strcmp(tagvalue, "disable") == 0)
+		cacheprocinfo = 0;
+	else
+		mcleanstop(1, "atoprc - %s: value 'enable' or 'disable' expected\n",
+								tagname);
+}
 
-		if (memcmp(line, "nonvoluntary_ctxt_switches:", 27)==0)
-		{
-			sscanf(line, "nonvoluntary_ctxt_switches: %lld", &(curtask->cpu.nivcsw));
-			continue;
-		}
-	}
+/*
+** handle the atoprc keyword 'skipidlethreads'
+*/
+void
+do_skipidlethreads(char *tagname, char *tagvalue)
+{
+	if (strcmp(tagvalue, "enable") == 0)
+		skipidlethr = 1;
+	else if (strcmp(tagvalue, "disable") == 0)
+		skipidlethr = 0;
+	else
+		mcleanstop(1, "atoprc - %s: value 'enable' or 'disable' expected\n",
+								tagname);
+}
 
-	fclose(fp);
-	return 1;
+/*
+** handle the atoprc keyword 'procfdcache'
+*/
+void
+do_procfdcache(char *tagname, char *tagvalue)
+{
+	if (strcmp(tagvalue, "enable") == 0)
+		procfdcache = 1;
+	else if (strcmp(tagvalue, "disable") == 0)
+		procfdcache = 0;
+	else
+		mcleanstop(1, "atoprc - %s: value 'enable' or 'disable' expected\n",
+								tagname);
 }
 
 /*
-** open file "io" (>= 2.6.20) and obtain required info
+** open file "stat" and obtain required info
 */
-#define	IO_READ		"read_bytes:"
-#define	IO_WRITE	"write_bytes:"
-#define	IO_CWRITE	"cancelled_write_bytes:"
 static int
-procio(struct tstat *curtask)
+procstat(struct tstat *curtask, struct taskref *tr,
+				unsigned long long bootepoch, char isproc)
 {
-	FILE	*fp;
 	char	line[4096];
-	count_t	dskrsz=0, dskwsz=0, dskcwsz=0;
 
-	if (supportflags & IOSTAT)
+	if ( readtask(tr, TF_STAT, line, sizeof line) <= 0)
+		return 0;
+
+	return parsestat(curtask, line, bootepoch, isproc);
+}
+
+/*
+** open file "status" and obtain required info
+*/
+static int
+procstatus(struct tstat *curtask, struct taskref *tr)
+{
+	char	sbuf[4096], *buf = sbuf;
+	size_t	bufsize = sizeof sbuf;
+	ssize_t	nr;
+
+	/*
+	** a status file that does not fit in the buffer (e.g. with
+	** a long list of supplementary groups) is read again with
+	** a larger buffer, because the context switches are at the end
+	*/
+	while ( (nr = readtask(tr, TF_STATUS, buf, bufsize)) == bufsize-1)
 	{
-		regainrootprivs();
+		bufsize *= 2;
+		buf      = realloc(buf == sbuf ? NULL : buf, bufsize);
 
-		if ( (fp = fopen("io", "r")) )
-		{
-			while (fgets(line, sizeof line, fp))
-			{
-				if (memcmp(line, IO_READ,
-						sizeof IO_READ -1) == 0)
-				{
-					sscanf(line, "%*s %llu", &dskrsz);
-					dskrsz /= 512;		// in sectors
-					continue;
-				}
+		ptrverify(buf, "Malloc failed for status buffer\n");
+	}
 
-				if (memcmp(line, IO_WRITE,
-						sizeof IO_WRITE -1) == 0)
-				{
-					sscanf(line, "%*s %llu", &dskwsz);
-					dskwsz /= 512;		// in sectors
-					continue;
-				}
+	if (nr != -1)
+		parsestatus(curtask, buf);
 
-				if (memcmp(line, IO_CWRITE,
-						sizeof IO_CWRITE -1) == 0)
-				{
-					sscanf(line, "%*s %llu", &dskcwsz);
-					dskcwsz /= 512;		// in sectors
-					continue;
-				}
-			}
+	if (buf != sbuf)
+		free(buf);
 
-			fclose(fp);
+	return nr != -1;
+}
 
-			curtask->dsk.rsz	= dskrsz;
-			curtask->dsk.rio	= dskrsz;  // to enable sort
-			curtask->dsk.wsz	= dskwsz;
-			curtask->dsk.wio	= dskwsz;  // to enable sort
-			curtask->dsk.cwsz	= dskcwsz;
-		}
+/*
+** open file "io" (>= 2.6.20) and obtain required info
+** (regain: root privileges not regained yet by the caller)
+*/
+static int
+procio(struct tstat *curtask, struct taskref *tr, char regain)
+{
+	char	buf[1024];
 
-		if (! droprootprivs())
+	if (supportflags & IOSTAT)
+	{
+		if (regain)
+			regainrootprivs();
+
+		if ( readtask(tr, TF_IO, buf, sizeof buf) != -1)
+			parseio(curtask, buf);
+
+		if (regain && !droprootprivs())
 			mcleanstop(42, "failed to drop root privs\n");
 	}
 
@@ -794,7 +1599,7 @@ procio(struct tstat *curtask)
 #define	ABBENVLEN	16
 
 static void
-proccmd(struct tstat *curtask)
+proccmd(struct tstat *curtask, int dirfd)
 {
 	FILE		*fp, *fpe;
 	register int 	i, nr;
@@ -804,8 +1609,11 @@ proccmd(struct tstat *curtask)
 	memset(curtask->gen.cmdline, 0, CMDLEN+1); // initialize command line
 
 	// prepend by environment variables (if required)
+	// never with root privileges obtained via the setuid-bit
+	// to avoid showing the environment of other users
 	//
-	if ( prependenv && (fpe = fopen("environ", "r")) != NULL)
+	if ( prependenv && geteuid() == getuid() &&
+	    (fpe = fopenat(dirfd, "environ")) != NULL)
 	{
 		char *line = NULL;
 		ssize_t nread;
@@ -851,7 +1659,7 @@ proccmd(struct tstat *curtask)
 
 	// add command line and parameters
 	//
-	if ( (fp = fopen("cmdline", "r")) != NULL)
+	if ( (fp = fopenat(dirfd, "cmdline")) != NULL)
 	{
 		nr = fread(pc, 1, CMDLEN-env_len, fp);
 		fclose(fp);
@@ -888,12 +1696,12 @@ proccmd(struct tstat *curtask)
 ** has been put in sleep state)
 */
 static void
-procwchan(struct tstat *curtask)
+procwchan(struct tstat *curtask, int dirfd)
 {
         FILE            *fp;
         register int    nr = 0;
 
-        if ( (fp = fopen("wchan", "r")) != NULL)
+        if ( (fp = fopenat(dirfd, "wchan")) != NULL)
         {
 
                 nr = fread(curtask->cpu.wchan, 1,
@@ -910,36 +1718,22 @@ procwchan(struct tstat *curtask)
 /*
 ** open file "smaps" and obtain required info
 ** since Linux-4.14, kernel supports "smaps_rollup" which has better
-** performence. check "smaps_rollup" in first call
+** performence. check "smaps_rollup" in first call of photoproc()
 ** if kernel supports "smaps_rollup", use "smaps_rollup" instead
 */
 static void
-procsmaps(struct tstat *curtask)
+procsmaps(struct tstat *curtask, int dirfd)
 {
 	FILE	*fp;
 	char	line[4096];
 	count_t	pssval;
-	static int procsmaps_firstcall = 1;
-	static char *smapsfile = "smaps";
-
-	if (procsmaps_firstcall)
-	{
-		regainrootprivs();
-		if ( (fp = fopen("/proc/1/smaps_rollup", "r")) )
-		{
-			smapsfile = "smaps_rollup";
-			fclose(fp);
-		}
-
-		procsmaps_firstcall = 0;
-	}
 
 	/*
  	** open the file (always succeeds, even if no root privs)
 	*/
 	regainrootprivs();
 
-	if ( (fp = fopen(smapsfile, "r")) )
+	if ( (fp = fopenat(dirfd, smapsfile)) )
 	{
 		curtask->mem.pmem = 0;
 
@@ -975,41 +1769,14 @@ procsmaps(struct tstat *curtask)
 ** ref: https://git.kernel.org/pub/scm/linux/kernel/git/torvalds/linux.git/tree/Documentation/scheduler/sched-stats.rst?h=v5.7-rc6
 */
 static count_t
-procschedstat(struct tstat *curtask)
+procschedstat(struct tstat *curtask, struct taskref *tr)
 {
-	FILE	*fp;
-	char	line[4096];
-	count_t	runtime, rundelay = 0;
-	unsigned long pcount;
-	static char *schedstatfile = "schedstat";
-
-	/*
- 	** open the schedstat file
-	*/
-	if ( (fp = fopen(schedstatfile, "r")) )
-	{
-		curtask->cpu.rundelay = 0;
-
-		if (fgets(line, sizeof line, fp))
-		{
-			sscanf(line, "%llu %llu %lu\n",
-					&runtime, &rundelay, &pcount);
+	char	buf[256];
 
-			curtask->cpu.rundelay = rundelay;
-		}
-
-		/*
-		** verify if fgets returned NULL due to error i.s.o. EOF
-		*/
-		if (ferror(fp))
-			curtask->cpu.rundelay = 0;
+	curtask->cpu.rundelay = 0;
 
-		fclose(fp);
-	}
-	else
-	{
-		curtask->cpu.rundelay = 0;
-	}
+	if ( readtask(tr, TF_SCHEDSTAT, buf, sizeof buf) > 0)
+		curtask->cpu.rundelay = parseschedstat(buf);
 
 	return curtask->cpu.rundelay;
 }
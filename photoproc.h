@@ -119,7 +119,9 @@ struct tstat {
 		count_t vlibs;		/* virtmem libexec  (Kb)     	*/
 		count_t vswap;		/* swap space used  (Kb)     	*/
 		count_t	vlock;		/* virtual locked   (Kb) 	*/
-		count_t	cfuture[7];	/* reserved for future use	*/
+		count_t	pmemage;	/* samples since PSS refresh	*/
+		count_t	pmemrss;	/* rmem at last PSS refresh (Kb)*/
+		count_t	cfuture[5];	/* reserved for future use	*/
 	} mem;
 
 	/* NETWORK STATISTICS						*/
@@ -158,9 +160,9 @@ struct tstat {
 
 
 struct pinfo {
-	struct pinfo	*phnext;	/* next process in hash    chain */
 	struct pinfo	*prnext;	/* next process in residue chain */
 	struct pinfo	*prprev;	/* prev process in residue chain */
+	struct pinfo	*prhnext;	/* next process in residue index */
 
 	struct tstat	tstat;		/* per-process statistics        */
 };
@@ -179,14 +181,18 @@ struct devtstat {
 	unsigned long	nprocactive;
 
         unsigned long   totrun, totslpi, totslpu, totidle, totzombie;
+
+	int		pinterval;	// interval covered by the deviations
 };
 
 /*
 ** prototypes of process-database functions
 */
 int		pdb_gettask(int, char, time_t, struct pinfo **);
+int		pdb_peektask(int, char, time_t, struct pinfo **);
+struct pinfo	*pdb_newtask(void);
 void		pdb_addtask(int, struct pinfo *);
-int		pdb_deltask(int, char);
+int		pdb_deltask(int, char, time_t);
 int		pdb_makeresidue(void);
 int		pdb_cleanresidue(void);
 int		pdb_srchresidue(struct tstat *, struct pinfo **);
@@ -198,9 +204,30 @@ struct netpertask;
 
 void		deviattask(struct tstat *, unsigned long,
  		           struct tstat *, unsigned long, 
- 		           struct devtstat *, struct sstat *);
+ 		           struct devtstat *, struct sstat *, int, int);
+
+unsigned long	photoproc(struct tstat **, unsigned long *);
+void		fdcache_evict(int, char, time_t);
+void		do_procfdcache(char *, char *);
+void		do_taskstats(char *, char *);
+void		do_skipidlethreads(char *, char *);
+void		do_cacheprocinfo(char *, char *);
 
-unsigned long	photoproc(struct tstat *, int);
-unsigned long	counttasks(void);
+/*
+** hits and misses of the cache of command lines and utsnames
+** (cumulative since atop started)
+*/
+struct pcachestat {
+	count_t	hits;
+	count_t	misses;
+};
+
+void		getpcachestat(struct pcachestat *);
+
+/*
+** prototypes of TASKSTATS functions
+*/
+int		taskstats_probe(void);
+int		taskstats_gettask(int, struct tstat *);
 
 #endif
@@ -52,6 +52,7 @@
 #include <sys/sysmacros.h>
 #include <sys/resource.h>
 #include <limits.h>
+#include <stddef.h>
 
 #define SCALINGMAXCPU	8	// threshold for scaling info per CPU
 
@@ -72,6 +73,7 @@
 #include "atop.h"
 #include "ifprop.h"
 #include "photosyst.h"
+#include "statfile.h"
 
 #define	MAXCNT	64
 
@@ -107,6 +109,27 @@ static int	get_ksm(struct sstat *);
 static int	isdisk_name(unsigned int, unsigned int,
 			char *, struct perdsk *, int);
 
+/*
+** cache with the outcome of isdisk_name() per block device, to avoid
+** the matching of regular expressions (and the mapping of LVM names)
+** for every line of /proc/diskstats during every sample
+*/
+#define	NDCHASH		1024		/* MUST be a power of 2 !!!	*/
+#define	DCHASH(x,y)	(((x)*31+(y))&(NDCHASH-1))
+
+struct dskclass {
+	struct dskclass	*next;
+	unsigned int	major;
+	unsigned int	minor;
+	char		*kname;		/* name as shown by kernel	*/
+	int		type;		/* DSKTYPE, MDDTYPE, ...	*/
+	char		name[MAXDKNAM];	/* (modified) name for atop	*/
+};
+
+static struct dskclass *dskclassify(unsigned int, unsigned int, char *);
+static int	scancounts(char **, count_t *, int);
+static char	*scantoken(char **);
+
 static struct bitmask *numa_allocate_cpumask(void);
 static void	numa_bitmask_free(struct bitmask *);
 static int	numa_parse_bitmap_v2(char *, struct bitmask *);
@@ -293,26 +316,20 @@ photosyst(struct sstat *si)
 	FILE 		*fp;
 	DIR		*dirp;
 	struct dirent	*dentry;
-	char		linebuf[1024], nam[64], origdir[4096];
+	char		linebuf[1024], nam[64], rootpath[1024];
 	unsigned int	major, minor;
 	struct shm_info	shminfo;
 #if	HTTPSTATS
 	static int	wwwvalid = 1;
 #endif
 
-	memset(si, 0, sizeof(struct sstat));
-
-	if ( getcwd(origdir, sizeof origdir) == NULL)
-		mcleanstop(54, "failed to save current dir\n");
-
-	if ( chdir("/proc") == -1)
-		mcleanstop(54, "failed to change to /proc\n");
+	clearsstat(si);
 
 	/*
 	** gather various general statistics from the file /proc/stat and
 	** store them in binary form
 	*/
-	if ( (fp = fopen("stat", "r")) != NULL)
+	if ( (fp = sfopen("/proc/stat")) != NULL)
 	{
 		while ( fgets(linebuf, sizeof(linebuf), fp) != NULL)
 		{
@@ -421,7 +438,7 @@ photosyst(struct sstat *si)
 	** gather loadaverage values from the file /proc/loadavg and
 	** store them in binary form
 	*/
-	if ( (fp = fopen("loadavg", "r")) != NULL)
+	if ( (fp = sfopen("/proc/loadavg")) != NULL)
 	{
 		if ( fgets(linebuf, sizeof(linebuf), fp) != NULL)
 		{
@@ -459,7 +476,7 @@ photosyst(struct sstat *si)
                    "/sys/devices/system/cpu/cpu%d/cpufreq/stats/time_in_state",
                    i);
 
-		if ((fp=fopen(fn, "r")) != 0)
+		if ((fp=sfopen(fn)) != 0)
 		{
                     long long hits=0;
                     long long maxfreq=0;
@@ -499,7 +516,7 @@ photosyst(struct sstat *si)
                		       "/sys/devices/system/cpu/cpu%d/cpufreq/cpuinfo_max_freq",
 			      i);
 
-               	 	if ((fp=fopen(fn, "r")) != 0)
+               	 	if ((fp=sfopen(fn)) != 0)
                 	{
                         	if (fscanf(fp, "%lld", &f) == 1)
                         	{
@@ -518,7 +535,7 @@ photosyst(struct sstat *si)
                        		"/sys/devices/system/cpu/cpu%d/cpufreq/scaling_cur_freq",
 		       	i);
         
-                	if ((fp=fopen(fn, "r")) != 0)
+                	if ((fp=sfopen(fn)) != 0)
                 	{
                  		if (fscanf(fp, "%lld", &f) == 1)
                         	{
@@ -541,7 +558,7 @@ photosyst(struct sstat *si)
         if (!didone)     // did not get processor freq statistics.
                          // use /proc/cpuinfo
         {
-	        if ( (fp = fopen("cpuinfo", "r")) != NULL)
+	        if ( (fp = sfopen("/proc/cpuinfo")) != NULL)
                 {
                         // get information from the lines
                         // processor\t: 0
@@ -580,7 +597,7 @@ photosyst(struct sstat *si)
 	si->mem.numamigrate  = 0;
 	si->mem.pgmigrate    = 0;
 
-	if ( (fp = fopen("vmstat", "r")) != NULL)
+	if ( (fp = sfopen("/proc/vmstat")) != NULL)
 	{
 		while ( fgets(linebuf, sizeof(linebuf), fp) != NULL)
 		{
@@ -716,7 +733,7 @@ photosyst(struct sstat *si)
 	si->mem.committed 	= (count_t) 0;
 	si->mem.pagetables 	= (count_t) 0;
 
-	if ( (fp = fopen("meminfo", "r")) != NULL)
+	if ( (fp = sfopen("/proc/meminfo")) != NULL)
 	{
 		while ( fgets(linebuf, sizeof(linebuf), fp) != NULL)
 		{
@@ -890,7 +907,7 @@ photosyst(struct sstat *si)
 		lhugepagetot  = (char *) -1;	// should be overwritten
 		lhugepagefree = (char *) -1;	// should be overwritten
 
-		dirp = opendir(HUGEPAGEDIR);
+		dirp = opendir(sfpath(HUGEPAGEDIR, rootpath, sizeof rootpath));
 
 		if (dirp)
 		{
@@ -946,7 +963,7 @@ photosyst(struct sstat *si)
 
 	// large hugepages for each interval:
 	//
-	if ( lhugepagetot != (char *)-1 && (fp = fopen(lhugepagetot, "r")) != NULL)
+	if ( lhugepagetot != (char *)-1 && (fp = sfopen(lhugepagetot)) != NULL)
 	{
 		if ( fgets(linebuf, sizeof(linebuf), fp) != NULL)
 			nr = sscanf(linebuf, "%lld", &si->mem.ltothugepage);
@@ -954,7 +971,7 @@ photosyst(struct sstat *si)
 		fclose(fp);
 	}
 
-	if ( lhugepagefree != (char *)-1 && (fp = fopen(lhugepagefree, "r")) != NULL)
+	if ( lhugepagefree != (char *)-1 && (fp = sfopen(lhugepagefree)) != NULL)
 	{
 		if ( fgets(linebuf, sizeof(linebuf), fp) != NULL)
 			nr = sscanf(linebuf, "%lld", &si->mem.lfreehugepage);
@@ -971,8 +988,8 @@ photosyst(struct sstat *si)
 	*/ 
 	si->mem.vmwballoon = (count_t) -1;
 
-	if ( (fp = fopen("/sys/kernel/debug/vmmemctl", "r")) != NULL ||
-	     (fp = fopen("/proc/vmmemctl",             "r")) != NULL   )
+	if ( (fp = sfopen("/sys/kernel/debug/vmmemctl")) != NULL ||
+	     (fp = sfopen("/proc/vmmemctl")) != NULL   )
 	{
 		while ( fgets(linebuf, sizeof(linebuf), fp) != NULL)
 		{
@@ -995,7 +1012,7 @@ photosyst(struct sstat *si)
 	*/ 
 	si->mem.zfsarcsize = (count_t) -1;
 
-	if ( (fp = fopen("spl/kstat/zfs/arcstats", "r")) != NULL)
+	if ( (fp = sfopen("/proc/spl/kstat/zfs/arcstats")) != NULL)
 	{
 		while ( fgets(linebuf, sizeof(linebuf), fp) != NULL)
 		{
@@ -1019,7 +1036,7 @@ photosyst(struct sstat *si)
 	** gather per numa memory-related statistics from the file
 	** /sys/devices/system/node/node0/meminfo, and store them in binary form.
 	*/
-	dirp = opendir(NUMADIR);
+	dirp = opendir(sfpath(NUMADIR, rootpath, sizeof rootpath));
 
 	if (dirp)
 	{
@@ -1040,7 +1057,7 @@ photosyst(struct sstat *si)
 
 			snprintf(fn, sizeof fn, NUMADIR "/%s/meminfo", dentry->d_name);
 
-			if ( (fp = fopen(fn, "r")) != NULL)
+			if ( (fp = sfopen(fn)) != NULL)
 			{
 				while ( fgets(linebuf, sizeof(linebuf), fp) != NULL)
 				{
@@ -1090,7 +1107,7 @@ photosyst(struct sstat *si)
 		float frag[MAX_ORDER];
 
 		/* If kernel CONFIG_COMPACTION is enabled, get the percentage directly */
-		if ( (fp = fopen("/sys/kernel/debug/extfrag/unusable_index", "r")) != NULL )
+		if ( (fp = sfopen("/sys/kernel/debug/extfrag/unusable_index")) != NULL )
 		{
 			while ( fgets(linebuf, sizeof(linebuf), fp) != NULL )
 			{
@@ -1111,7 +1128,7 @@ photosyst(struct sstat *si)
 			fclose(fp);
 		}
 		/* If CONFIG_COMPACTION is not enabled, calculate from buddyinfo file */
-		else if ( (fp = fopen("/proc/buddyinfo", "r")) != NULL )
+		else if ( (fp = sfopen("/proc/buddyinfo")) != NULL )
 		{
 			count_t free_page[MAX_ORDER];
 			count_t total_free, prev_free;
@@ -1171,7 +1188,7 @@ photosyst(struct sstat *si)
 		{
 			snprintf(fn, sizeof fn, NUMADIR "/node%d/cpumap", j);
 
-			if ( (fp = fopen(fn, "r")) != 0)
+			if ( (fp = sfopen(fn)) != 0)
 			{
 				if ( getdelim(&line, &len, '\n', fp) > 0 )
 				{
@@ -1223,44 +1240,33 @@ photosyst(struct sstat *si)
 	*/
 	initifprop();   // periodically refresh interface properties
 
-	if ( (fp = fopen("net/dev", "r")) != NULL)
+	if ( (fp = sfopen("/proc/net/dev")) != NULL)
 	{
-		struct ifprop ifprop;
-		char *cp;
+		struct ifprop	ifprop;
+		struct perintf	*pi;
+		char		*cp, *name;
 
 		i = 0;
 
 		while ( fgets(linebuf, sizeof(linebuf), fp) != NULL)
 		{
-			if ( (cp = strchr(linebuf, ':')) != NULL)
-				*cp = ' ';      /* substitute ':' by space */
+			/*
+			** skip header lines (no colon after the name)
+			*/
+			if ( (cp = strchr(linebuf, ':')) == NULL)
+				continue;
 
-			nr = sscanf(linebuf,
-                                    "%15s %lld %lld %lld %lld %lld %lld %lld "
-                                    "%lld %lld %lld %lld %lld %lld %lld %lld "
-                                    "%lld\n",
-				  si->intf.intf[i].name,
-				&(si->intf.intf[i].rbyte),
-				&(si->intf.intf[i].rpack),
-				&(si->intf.intf[i].rerrs),
-				&(si->intf.intf[i].rdrop),
-				&(si->intf.intf[i].rfifo),
-				&(si->intf.intf[i].rframe),
-				&(si->intf.intf[i].rcompr),
-				&(si->intf.intf[i].rmultic),
-				&(si->intf.intf[i].sbyte),
-				&(si->intf.intf[i].spack),
-				&(si->intf.intf[i].serrs),
-				&(si->intf.intf[i].sdrop),
-				&(si->intf.intf[i].sfifo),
-				&(si->intf.intf[i].scollis),
-				&(si->intf.intf[i].scarrier),
-				&(si->intf.intf[i].scompr));
+			*cp++ = '\0';
+
+			name = linebuf;
+
+			if ( (name = scantoken(&name)) == NULL)
+				continue;
 
 			/*
-			** skip header line and lines without stats
+			** skip lines without stats
 			*/
-			if (nr != 17)
+			if (scancounts(&cp, cnts, 16) != 16)
 				continue;
 
 			/*
@@ -1269,11 +1275,32 @@ photosyst(struct sstat *si)
 			** because the total number of interfaces
 			** exceeds the maximum supported by atop (MAXINTF)
 			*/
-			strcpy(ifprop.name, si->intf.intf[i].name);
+			safe_strcpy(ifprop.name, name, sizeof pi->name);
 
 			if (!getifprop(&ifprop))
 				continue;
 
+			pi = &si->intf.intf[i];
+
+			strcpy(pi->name, ifprop.name);
+
+			pi->rbyte	= cnts[0];
+			pi->rpack	= cnts[1];
+			pi->rerrs	= cnts[2];
+			pi->rdrop	= cnts[3];
+			pi->rfifo	= cnts[4];
+			pi->rframe	= cnts[5];
+			pi->rcompr	= cnts[6];
+			pi->rmultic	= cnts[7];
+			pi->sbyte	= cnts[8];
+			pi->spack	= cnts[9];
+			pi->serrs	= cnts[10];
+			pi->sdrop	= cnts[11];
+			pi->sfifo	= cnts[12];
+			pi->scollis	= cnts[13];
+			pi->scarrier	= cnts[14];
+			pi->scompr	= cnts[15];
+
 			/*
 			** accept this interface but skip the remaining
 			** interfaces because we reached the total number
@@ -1292,7 +1319,7 @@ photosyst(struct sstat *si)
 	/*
 	** IP version 4 statistics
 	*/
-	if ( (fp = fopen("net/snmp", "r")) != NULL)
+	if ( (fp = sfopen("/proc/net/snmp")) != NULL)
 	{
 		while ( fgets(linebuf, sizeof(linebuf), fp) != NULL)
 		{
@@ -1356,7 +1383,7 @@ photosyst(struct sstat *si)
 	memset(&icmpv6_tmp, 0, sizeof icmpv6_tmp);
 	memset(&udpv6_tmp,  0, sizeof udpv6_tmp);
 
-	if ( (fp = fopen("net/snmp6", "r")) != NULL)
+	if ( (fp = sfopen("/proc/net/snmp6")) != NULL)
 	{
 		count_t	countval;
 		int	cur = 0;
@@ -1399,7 +1426,7 @@ photosyst(struct sstat *si)
 	/*
 	** IP version 4: TCP & UDP memory allocations.
 	*/
-	if ( (fp = fopen("net/sockstat", "r")) != NULL)
+	if ( (fp = sfopen("/proc/net/sockstat")) != NULL)
 	{
 		char tcpmem[16], udpmem[16];
 
@@ -1431,7 +1458,7 @@ photosyst(struct sstat *si)
 	/*
 	** check if extended partition-statistics are provided < kernel 2.6
 	*/
-	if ( part_stats && (fp = fopen("partitions", "r")) != NULL)
+	if ( part_stats && (fp = sfopen("/proc/partitions")) != NULL)
 	{
 		char diskname[256];
 
@@ -1481,10 +1508,11 @@ photosyst(struct sstat *si)
 	/*
 	** check if disk-statistics are provided (kernel 2.6 onwards)
 	*/
-	if ( (fp = fopen("diskstats", "r")) != NULL)
+	if ( (fp = sfopen("/proc/diskstats")) != NULL)
 	{
-		char 		diskname[256];
-		struct perdsk	tmpdsk;
+		struct dskclass	*dc;
+		struct perdsk	*pd;
+		char 		*cp, *diskname;
 
 		si->dsk.ndsk = 0;
 		si->dsk.nmdd = 0;
@@ -1492,57 +1520,83 @@ photosyst(struct sstat *si)
 
 		while ( fgets(linebuf, sizeof(linebuf), fp) )
 		{
-			/* discards are not supported in older kernels */
- 			tmpdsk.ndisc = -1;
+			/*
+			** ident: major, minor and name
+			*/
+			cp = linebuf;
 
-			nr = sscanf(linebuf,
-			      "%d %d %255s "		// ident
-                              "%lld %*d %lld %*d "	// reads
-			      "%lld %*d %lld %*d "	// writes
-			      "%lld %lld %lld "		// misc
-			      "%lld %*d %lld %*d",	// discards
-				&major, &minor, diskname,
-				&tmpdsk.nread,  &tmpdsk.nrsect,
-				&tmpdsk.nwrite, &tmpdsk.nwsect,
-				&tmpdsk.inflight, &tmpdsk.io_ms, &tmpdsk.avque,
-				&tmpdsk.ndisc,  &tmpdsk.ndsect);
-
-			if (nr >= 10)	/* full stats-line ? */
+			if (scancounts(&cp, cnts, 2) != 2)
+				continue;
+
+			major = cnts[0];
+			minor = cnts[1];
+
+			if ( (diskname = scantoken(&cp)) == NULL)
+				continue;
+
+			/*
+			** counters: reads (0-3), writes (4-7), misc (8-10)
+			** and discards (11-14, not in older kernels)
+			*/
+			nr = scancounts(&cp, cnts, 14);
+
+			if (nr < 11)	/* no full stats-line ? */
+				continue;
+
+			if (nr < 12)
+				cnts[11] = -1;	/* discards not supported */
+
+			if (nr < 14)
+				cnts[13] = 0;
+
+			/*
+			** when no transfers issued, skip disk (partition)
+			*/
+			if (cnts[0] + cnts[4] + (cnts[11] == -1 ? 0 : cnts[11]) == 0)
+				continue;
+
+			/*
+			** check if this line concerns the entire disk
+			** or just one of the partitions of a disk (to be
+			** skipped); the outcome is cached per device
+			*/
+			dc = dskclassify(major, minor, diskname);
+
+			switch (dc->type)
 			{
-				/*
-  				** when no transfers issued, skip disk (partition)
-				*/
-				if (tmpdsk.nread + tmpdsk.nwrite +
-				     (tmpdsk.ndisc == -1 ? 0 : tmpdsk.ndisc) == 0)
+			   case DSKTYPE:
+				if (si->dsk.ndsk >= MAXDSK-1)
 					continue;
+				pd = &si->dsk.dsk[si->dsk.ndsk++];
+				break;
 
-				/*
-				** check if this line concerns the entire disk
-				** or just one of the partitions of a disk (to be
-				** skipped)
-				*/
-				switch ( isdisk_name(major, minor, diskname,
-							 &tmpdsk, MAXDKNAM) )
-				{
-				   case NONTYPE:
-				       continue;
-
-				   case DSKTYPE:
-					if (si->dsk.ndsk < MAXDSK-1)
-					  si->dsk.dsk[si->dsk.ndsk++] = tmpdsk;
-					break;
+			   case MDDTYPE:
+				if (si->dsk.nmdd >= MAXMDD-1)
+					continue;
+				pd = &si->dsk.mdd[si->dsk.nmdd++];
+				break;
 
-				   case MDDTYPE:
-					if (si->dsk.nmdd < MAXMDD-1)
-					  si->dsk.mdd[si->dsk.nmdd++] = tmpdsk;
-					break;
+			   case LVMTYPE:
+				if (si->dsk.nlvm >= MAXLVM-1)
+					continue;
+				pd = &si->dsk.lvm[si->dsk.nlvm++];
+				break;
 
-				   case LVMTYPE:
-					if (si->dsk.nlvm < MAXLVM-1)
-					  si->dsk.lvm[si->dsk.nlvm++] = tmpdsk;
-					break;
-				}
+			   default:
+				continue;
 			}
+
+			memcpy(pd->name, dc->name, MAXDKNAM);
+
+			pd->nread	= cnts[0];
+			pd->nrsect	= cnts[2];
+			pd->nwrite	= cnts[4];
+			pd->nwsect	= cnts[6];
+			pd->inflight	= cnts[8];
+			pd->io_ms	= cnts[9];
+			pd->avque	= cnts[10];
+			pd->ndisc	= cnts[11];
+			pd->ndsect	= cnts[13];
 		}
 
 		/*
@@ -1567,7 +1621,7 @@ photosyst(struct sstat *si)
 	/*
 	** NFS server statistics
 	*/
-	if ( (fp = fopen("net/rpc/nfsd", "r")) != NULL)
+	if ( (fp = sfopen("/proc/net/rpc/nfsd")) != NULL)
 	{
 		char    label[32];
 		count_t	cnt[40];
@@ -1668,7 +1722,7 @@ photosyst(struct sstat *si)
 	/*
 	** NFS client statistics
 	*/
-	if ( (fp = fopen("net/rpc/nfs", "r")) != NULL)
+	if ( (fp = sfopen("/proc/net/rpc/nfs")) != NULL)
 	{
 		char    label[32];
 		count_t	cnt[10];
@@ -1729,7 +1783,7 @@ photosyst(struct sstat *si)
 	*/
 	regainrootprivs();
 
-	if ( (fp = fopen("self/mountstats", "r")) != NULL)
+	if ( (fp = sfopen("/proc/self/mountstats")) != NULL)
 	{
 		char 	mountdev[128], fstype[32], label[32];
                 count_t	cnt[8];
@@ -1810,7 +1864,8 @@ photosyst(struct sstat *si)
 	**
 	** verify if pressure stats supported by this system
 	*/
-	if ( chdir("pressure") == 0)
+	if ( access(sfpath("/proc/pressure", rootpath, sizeof rootpath),
+								F_OK) == 0)
  	{
 		struct psi 	psitemp;
 		char 		psitype;
@@ -1819,7 +1874,7 @@ photosyst(struct sstat *si)
 
 		si->psi.present = 1;
 
-		if ( (fp = fopen("cpu", "r")) != NULL)
+		if ( (fp = sfopen("/proc/pressure/cpu")) != NULL)
 		{
 			while ( fgets(linebuf, sizeof(linebuf), fp) != NULL)
 			{
@@ -1839,7 +1894,7 @@ photosyst(struct sstat *si)
 			fclose(fp);
 		}
 
-		if ( (fp = fopen("memory", "r")) != NULL)
+		if ( (fp = sfopen("/proc/pressure/memory")) != NULL)
 		{
 			while ( fgets(linebuf, sizeof(linebuf), fp) != NULL)
 			{
@@ -1861,7 +1916,7 @@ photosyst(struct sstat *si)
 			fclose(fp);
 		}
 
-		if ( (fp = fopen("io", "r")) != NULL)
+		if ( (fp = sfopen("/proc/pressure/io")) != NULL)
 		{
 			while ( fgets(linebuf, sizeof(linebuf), fp) != NULL)
 			{
@@ -1884,9 +1939,6 @@ photosyst(struct sstat *si)
 			}
 			fclose(fp);
 		}
-
-		if ( chdir("..") == -1)
-			mcleanstop(54, "failed to return to /proc\n");
 	}
 	else
 	{
@@ -1896,7 +1948,7 @@ photosyst(struct sstat *si)
 	/*
 	** Container statistics (if any)
 	*/
-	if ( (fp = fopen("user_beancounters", "r")) != NULL)
+	if ( (fp = sfopen("/proc/user_beancounters")) != NULL)
 	{
 		unsigned long	ctid;
 		char    	label[32];
@@ -1948,7 +2000,7 @@ photosyst(struct sstat *si)
 
 		si->cfs.nrcontainer = i+1;
 
-		if ( (fp = fopen("vz/vestat", "r")) != NULL)
+		if ( (fp = sfopen("/proc/vz/vestat")) != NULL)
 		{
 			unsigned long	ctid;
 			count_t		cnt[8];
@@ -1992,7 +2044,7 @@ photosyst(struct sstat *si)
 	** gather per LLC related statistics from the file
 	** /sys/fs/resctrl/mon_data/mon_L3_XX
 	*/
-	dirp = opendir(LLCDIR);
+	dirp = opendir(sfpath(LLCDIR, rootpath, sizeof rootpath));
 
 	if (dirp)
 	{
@@ -2000,7 +2052,8 @@ photosyst(struct sstat *si)
 
 		if (!l3_cache_size)
 		{
-			if ( (fp = fopen(L3SIZE, "r")) != NULL)
+			if ( (fp = fopen(sfpath(L3SIZE, rootpath,
+					sizeof rootpath), "r")) != NULL)
 			{
 				if ( fgets(linebuf, sizeof(linebuf), fp) != NULL)
 				{
@@ -2027,7 +2080,7 @@ photosyst(struct sstat *si)
 			sscanf(dentry->d_name + 7, "%hhd\n", &llc->id);
 
 			snprintf(fn, sizeof fn, LLCDIR "/%s/llc_occupancy", dentry->d_name);
-			if ( (fp = fopen(fn, "r")) != NULL)
+			if ( (fp = sfopen(fn)) != NULL)
 			{
 				if ( fgets(linebuf, sizeof(linebuf), fp) != NULL)
 				{
@@ -2039,7 +2092,7 @@ photosyst(struct sstat *si)
 			}
 
 			snprintf(fn, sizeof fn, LLCDIR "/%s/mbm_local_bytes", dentry->d_name);
-			if ( (fp = fopen(fn, "r")) != NULL)
+			if ( (fp = sfopen(fn)) != NULL)
 			{
 				if ( fgets(linebuf, sizeof(linebuf), fp) != NULL)
 				{
@@ -2050,7 +2103,7 @@ photosyst(struct sstat *si)
 			}
 
 			snprintf(fn, sizeof fn, LLCDIR "/%s/mbm_total_bytes", dentry->d_name);
-			if ( (fp = fopen(fn, "r")) != NULL)
+			if ( (fp = sfopen(fn)) != NULL)
 			{
 				if ( fgets(linebuf, sizeof(linebuf), fp) != NULL)
 				{
@@ -2079,12 +2132,6 @@ photosyst(struct sstat *si)
 	if (ksm_stats)
 		ksm_stats = get_ksm(si);
 
-	/*
- 	** return to original directory
-	*/
-	if ( chdir(origdir) == -1)
-		mcleanstop(55, "failed to change to %s\n", origdir);
-
 #ifndef	NOPERFEVENT
 	/*
 	** get low-level CPU event counters
@@ -2227,6 +2274,117 @@ lvmmapname(unsigned int major, unsigned int minor,
 	safe_strcpy(px->name, curname, maxlen);
 }
 
+/*
+** cache with the outcome of isdisk_name() per block device
+*/
+static struct dskclass	*dchash[NDCHASH];
+
+static struct dskclass *
+dskclassify(unsigned int major, unsigned int minor, char *kname)
+{
+	struct dskclass	*dc;
+	struct perdsk	tmpdsk;
+	int		hashix = DCHASH(major, minor);
+
+	for (dc = dchash[hashix]; dc; dc = dc->next)
+	{
+		if (dc->major == major && dc->minor == minor)
+		{
+			if (strcmp(dc->kname, kname) == 0)
+				return dc;
+
+			/*
+			** device number reused for another device
+			*/
+			free(dc->kname);
+			break;
+		}
+	}
+
+	if (!dc)
+	{
+		dc = malloc(sizeof *dc);
+		ptrverify(dc, "Malloc failed for disk classification\n");
+
+		dc->major	= major;
+		dc->minor	= minor;
+		dc->next	= dchash[hashix];
+		dchash[hashix]	= dc;
+	}
+
+	dc->kname = strdup(kname);
+	ptrverify(dc->kname, "Malloc failed for disk classification\n");
+
+	memset(&tmpdsk, 0, sizeof tmpdsk);
+
+	dc->type = isdisk_name(major, minor, kname, &tmpdsk, MAXDKNAM);
+
+	memcpy(dc->name, tmpdsk.name, MAXDKNAM);
+
+	return dc;
+}
+
+/*
+** specialised replacement of sscanf() for lines with series of
+** unsigned decimal numbers (like /proc/diskstats and /proc/net/dev);
+** the scan pointer is moved behind the last number scanned
+**
+** return value: number of values stored
+*/
+static int
+scancounts(char **pp, count_t *vals, int maxvals)
+{
+	char	*p = *pp;
+	count_t	val;
+	int	n;
+
+	for (n=0; n < maxvals; n++)
+	{
+		while (*p == ' ' || *p == '\t')
+			p++;
+
+		if (*p < '0' || *p > '9')
+			break;
+
+		for (val=0; *p >= '0' && *p <= '9'; p++)
+			val = val * 10 + *p - '0';
+
+		vals[n] = val;
+	}
+
+	*pp = p;
+
+	return n;
+}
+
+/*
+** isolate the next word (terminated by a null-byte) and
+** move the scan pointer behind it
+**
+** return value: pointer to word or NULL (end of line)
+*/
+static char *
+scantoken(char **pp)
+{
+	char	*p = *pp, *word;
+
+	while (*p == ' ' || *p == '\t')
+		p++;
+
+	if (*p == '\0' || *p == '\n')
+		return NULL;
+
+	for (word = p; *p && *p != ' ' && *p != '\t' && *p != '\n'; p++)
+		;
+
+	if (*p)
+		*p++ = '\0';
+
+	*pp = p;
+
+	return word;
+}
+
 /*
 ** this table is used in the functions isdisk_name() and isdick_major()
 **
@@ -2331,6 +2489,8 @@ isdisk_major(unsigned int major)
 ** get stats of all InfiniBand ports below
 **    /sys/class/infiniband/<controller>/ports/<port#>/....
 */
+#define	IBDIR	"/sys/class/infiniband"
+
 static struct ibcachent {
 	char		*ibha;		// InfiniBand Host Adaptor
 	unsigned short	port;		// port number
@@ -2352,9 +2512,11 @@ get_infiniband(struct ifbstat *si)
 {
 	static int	firstcall = 1;
 	int		i;
+	char		rootpath[PATH_MAX];
+	const char	*ibdir = sfpath(IBDIR, rootpath, sizeof rootpath);
 
 	// verify if InfiniBand used in this system
-	if ( chdir("/sys/class/infiniband") == -1)
+	if ( access(ibdir, F_OK) == -1)
 		return 0;	// no path, no IB, so don't try again
 
 	if (firstcall)
@@ -2371,7 +2533,7 @@ get_infiniband(struct ifbstat *si)
 		** to gather the necessary stats with every subsequent
 		** call, including  path names, etcetera.
 		*/
-		if ( (contp = opendir(".")) )
+		if ( (contp = opendir(ibdir)) )
 		{
 			/*
  			** read every directory-entry and search for
@@ -2383,7 +2545,10 @@ get_infiniband(struct ifbstat *si)
 				if (contdent->d_name[0] == '.')
 					continue;
 
-				if ( stat(contdent->d_name, &statbuf) == -1 )
+				snprintf(path, sizeof path, "%s/%s",
+						ibdir, contdent->d_name);
+
+				if ( stat(path, &statbuf) == -1 )
 					continue;
 	
 				if ( ! S_ISDIR(statbuf.st_mode) )
@@ -2400,8 +2565,8 @@ get_infiniband(struct ifbstat *si)
 
 				// discover all ports
 				//
-				snprintf(path, sizeof path, "%s/ports",
-							contdent->d_name);
+				snprintf(path, sizeof path, "%s/%s/ports",
+						ibdir, contdent->d_name);
 
 				if ( (portp = opendir(path)) )
 				{
@@ -2475,12 +2640,13 @@ static void
 ibprep(struct ibcachent *ibc)
 {
 	FILE	*fp;
-	char	path[PATH_MAX], linebuf[64], speedunit;
+	char	path[PATH_MAX], rootpath[PATH_MAX], linebuf[64], speedunit;
 
 	// determine port rate and number of lanes
-	snprintf(path, sizeof path, "%s/ports/%d/rate", ibc->ibha, ibc->port); 
+	snprintf(path, sizeof path, IBDIR "/%s/ports/%d/rate",
+						ibc->ibha, ibc->port);
 
-	if ( (fp = fopen(path, "r")) )
+	if ( (fp = fopen(sfpath(path, rootpath, sizeof rootpath), "r")) )
 	{
 		if ( fgets(linebuf, sizeof(linebuf), fp) != NULL)
 		{
@@ -2515,22 +2681,26 @@ ibprep(struct ibcachent *ibc)
 
 	// build all pathnames to obtain the counters
 	// of this port later on
-	snprintf(path, sizeof path, "%s/ports/%d/counters/port_rcv_data",
+	snprintf(path, sizeof path,
+			IBDIR "/%s/ports/%d/counters/port_rcv_data",
 						    ibc->ibha, ibc->port);
 	ibc->pathrcvb = malloc( strlen(path)+1 );
 	strcpy(ibc->pathrcvb, path);
 
-	snprintf(path, sizeof path, "%s/ports/%d/counters/port_xmit_data",
+	snprintf(path, sizeof path,
+			IBDIR "/%s/ports/%d/counters/port_xmit_data",
 						    ibc->ibha, ibc->port);
 	ibc->pathsndb = malloc( strlen(path)+1 );
 	strcpy(ibc->pathsndb, path);
 
-	snprintf(path, sizeof path, "%s/ports/%d/counters/port_rcv_packets",
+	snprintf(path, sizeof path,
+			IBDIR "/%s/ports/%d/counters/port_rcv_packets",
 						    ibc->ibha, ibc->port);
 	ibc->pathrcvp = malloc( strlen(path)+1 );
 	strcpy(ibc->pathrcvp, path);
 
-	snprintf(path, sizeof path, "%s/ports/%d/counters/port_xmit_packets",
+	snprintf(path, sizeof path,
+			IBDIR "/%s/ports/%d/counters/port_xmit_packets",
 						    ibc->ibha, ibc->port);
 	ibc->pathsndp = malloc( strlen(path)+1 );
 	strcpy(ibc->pathsndp, path);
@@ -2542,64 +2712,21 @@ ibprep(struct ibcachent *ibc)
 static int
 ibstat(struct ibcachent *ibc, struct perifb *ifb)
 {
-	FILE	*fp;
-	char	linebuf[64];
-
-	if ( (fp = fopen(ibc->pathrcvb, "r")) )
-	{
-		if ( fgets(linebuf, sizeof(linebuf), fp) != NULL)
-		{
-			if (sscanf(linebuf, "%lld", &(ifb->rcvb)) == 0)
-				ifb->rcvb = 0;
-		}
-		else
-		{
-			ifb->rcvb = 0;
-		}
-		fclose(fp);
-	}
+	/*
+	** the counter files are kept open by the registry of
+	** statistics files and only reread (no stdio stream)
+	*/
+	if (!sfgetval(ibc->pathrcvb, &(ifb->rcvb)))
+		ifb->rcvb = 0;
 
-	if ( (fp = fopen(ibc->pathsndb, "r")) )
-	{
-		if ( fgets(linebuf, sizeof(linebuf), fp) != NULL)
-		{
-			if (sscanf(linebuf, "%lld", &(ifb->sndb)) == 0)
-				ifb->sndb = 0;
-		}
-		else
-		{
-			ifb->sndb = 0;
-		}
-		fclose(fp);
-	}
+	if (!sfgetval(ibc->pathsndb, &(ifb->sndb)))
+		ifb->sndb = 0;
 
-	if ( (fp = fopen(ibc->pathrcvp, "r")) )
-	{
-		if ( fgets(linebuf, sizeof(linebuf), fp) != NULL)
-		{
-			if (sscanf(linebuf, "%lld", &(ifb->rcvp)) == 0)
-				ifb->rcvp = 0;
-		}
-		else
-		{
-			ifb->rcvp = 0;
-		}
-		fclose(fp);
-	}
+	if (!sfgetval(ibc->pathrcvp, &(ifb->rcvp)))
+		ifb->rcvp = 0;
 
-	if ( (fp = fopen(ibc->pathsndp, "r")) )
-	{
-		if ( fgets(linebuf, sizeof(linebuf), fp) != NULL)
-		{
-			if (sscanf(linebuf, "%lld", &(ifb->sndp)) == 0)
-				ifb->sndp = 0;
-		}
-		else
-		{
-			ifb->sndp = 0;
-		}
-		fclose(fp);
-	}
+	if (!sfgetval(ibc->pathsndp, &(ifb->sndp)))
+		ifb->sndp = 0;
 
 	return 1;
 }
@@ -2616,7 +2743,7 @@ get_ksm(struct sstat *si)
 	si->mem.ksmsharing = -1;
 	si->mem.ksmshared  = -1;
 
-	if ((fp=fopen("/sys/kernel/mm/ksm/run", "r")) != 0)
+	if ((fp=sfopen("/sys/kernel/mm/ksm/run")) != 0)
 	{
 		if (fscanf(fp, "%d", &state) == 1)
 		{
@@ -2630,7 +2757,7 @@ get_ksm(struct sstat *si)
 		fclose(fp);
 	}
 
-	if ((fp=fopen("/sys/kernel/mm/ksm/pages_sharing", "r")) != 0)
+	if ((fp=sfopen("/sys/kernel/mm/ksm/pages_sharing")) != 0)
 	{
 		if (fscanf(fp, "%llu", &(si->mem.ksmsharing)) != 1)
 			si->mem.ksmsharing = 0;
@@ -2638,7 +2765,7 @@ get_ksm(struct sstat *si)
 		fclose(fp);
 	}
 
-	if ((fp=fopen("/sys/kernel/mm/ksm/pages_shared", "r")) != 0)
+	if ((fp=sfopen("/sys/kernel/mm/ksm/pages_shared")) != 0)
 	{
 		if (fscanf(fp, "%llu", &(si->mem.ksmshared)) != 1)
 			si->mem.ksmshared = 0;
@@ -2661,9 +2788,10 @@ realnuma_support(void)
 {
 	FILE		*fp;
 	int		i, total, nr=0, dist[10];
-	char		linebuf[1024];
+	char		linebuf[1024], rootpath[1024];
 
-	if ( (fp = fopen(NUMADISTANCE0, "r")) == NULL)
+	if ( (fp = fopen(sfpath(NUMADISTANCE0, rootpath, sizeof rootpath),
+							"r")) == NULL)
 		return;		// open failed
 
 	if ( fgets(linebuf, sizeof(linebuf), fp) != NULL)
@@ -2696,9 +2824,10 @@ void
 zswap_support(void)
 {
 	FILE *fp;
-	char  state;
+	char  state, rootpath[1024];
 
-	if ((fp=fopen("/sys/module/zswap/parameters/enabled", "r")) == NULL)
+	if ((fp=fopen(sfpath("/sys/module/zswap/parameters/enabled",
+				rootpath, sizeof rootpath), "r")) == NULL)
 		return;		// open failed
 
 	if (fscanf(fp, "%c", &state) == 1 && state == 'Y')
@@ -2864,12 +2993,91 @@ perf_event_open(struct perf_event_attr *hwevent, pid_t pid,
 	return syscall(__NR_perf_event_open, hwevent, pid, cpu, groupfd, flags);
 }
 
+/*
+** hardware events retrieved per CPU in two groups: the pinned group
+** with cycles and instructions and the group with the extra events
+** that are only retrieved when selected via the atoprc keyword
+** 'perfextra'; the extra events are kept out of the pinned group,
+** because a pinned group that can not be scheduled on the PMU
+** (e.g. when the hardware counters are also claimed by others)
+** does not count at all
+*/
+static struct perfev {
+	char		*name;		/* name in atoprc		*/
+	unsigned long	config;		/* PERF_COUNT_HW_...		*/
+	size_t		offset;		/* counter in struct percpu	*/
+	char		selected;	/* boolean: to be retrieved	*/
+	char		group;		/* 0: pinned, 1: extra		*/
+} perfevs[] = {
+	{ "cycle",	PERF_COUNT_HW_CPU_CYCLES,
+				offsetof(struct percpu, cycle),		1, 0 },
+	{ "instr",	PERF_COUNT_HW_INSTRUCTIONS,
+				offsetof(struct percpu, instr),		1, 0 },
+	{ "cachemiss",	PERF_COUNT_HW_CACHE_MISSES,
+				offsetof(struct percpu, cachemiss),	0, 1 },
+	{ "branchmiss",	PERF_COUNT_HW_BRANCH_MISSES,
+				offsetof(struct percpu, branchmiss),	0, 1 },
+	{ "stalled",	PERF_COUNT_HW_STALLED_CYCLES_BACKEND,
+				offsetof(struct percpu, stalled),	0, 1 },
+};
+
+#define	NPERFEVS	(sizeof perfevs / sizeof perfevs[0])
+#define	NPERFGRPS	2	/* pinned group and extra group	*/
+#define	PERFCNT(pc, ev)	(*(count_t *)((char *)(pc) + perfevs[ev].offset))
+
+/*
+** per CPU and group: the descriptors of the events in the group,
+** the event index for every position in the group read and the
+** values of the previous read to extrapolate per interval
+*/
+struct perfgroup {
+	int		fds[NPERFEVS];	/* descriptor per event or -1	*/
+	int		nmembers;	/* number of events in group	*/
+	unsigned char	member[NPERFEVS];	/* event per position	*/
+	count_t		enabled;	/* previous time enabled	*/
+	count_t		running;	/* previous time running	*/
+	count_t		value[NPERFEVS];	/* previous raw value	*/
+	count_t		scaled[NPERFEVS];	/* extrapolated value	*/
+};
+
+void
+do_perfextra(char *tagname, char *tagvalue)
+{
+	char	*p, *save, list[256];
+	int	i;
+
+	strncpy(list, tagvalue, sizeof list - 1);
+	list[sizeof list - 1] = '\0';
+
+	for (p = strtok_r(list, ", \t", &save); p;
+	     p = strtok_r(NULL, ", \t", &save))
+	{
+		for (i=2; i < NPERFEVS; i++)	// instr/cycle always selected
+		{
+			if (strcmp(p, perfevs[i].name) == 0)
+			{
+				perfevs[i].selected = 1;
+				break;
+			}
+		}
+
+		if (i == NPERFEVS)
+			mcleanstop(1, "atoprc - %s: unknown event '%s' "
+			              "(cachemiss, branchmiss or stalled expected)\n",
+			              tagname, p);
+	}
+}
+
 static void
 getperfevents(struct cpustat *cs)
 {
-	static int	firstcall = 1, cpualloced, *fdi, *fdc;
-	int		i;
-	int 		liResult;
+	static int		firstcall = 1, cpualloced;
+	static struct perfgroup	*pgs;
+	struct perfgroup	*pg;
+	count_t			buf[3+NPERFEVS];  // nr + times + values
+	count_t			val, enabled, running;
+	int			i, j, g, ev;
+	ssize_t			liResult;
 
 	if (!enable_perfevents())
 		return;
@@ -2880,16 +3088,21 @@ getperfevents(struct cpustat *cs)
 	if (firstcall)
 	{
 		struct perf_event_attr  pea;
-		int			success=0, minfds = cs->nrcpu*2 + 32;
+		int			success=0, nevs, minfds;
 		struct rlimit		rlim;
 
 		firstcall = 0;
 
+		for (ev=0, nevs=0; ev < NPERFEVS; ev++)
+			nevs += perfevs[ev].selected;
+
 		/*
-		** for perf events two file descriptors will
+		** for perf events one file descriptor per event will
 		** be opened permanently per CPU, so take care
 		** that enough open files are allowed for this process
 		*/
+		minfds = cs->nrcpu * nevs + 32;
+
 		getrlimit(RLIMIT_NOFILE, &rlim);
 
 		if (rlim.rlim_cur < minfds)	// default not enough?
@@ -2899,37 +3112,56 @@ getperfevents(struct cpustat *cs)
 		}
 
 		/*
-		** allocate space for per-cpu file descriptors
+		** allocate space for per-cpu event groups
 		*/
 		cpualloced = cs->nrcpu;
-		fdi        = malloc(sizeof(int) * cpualloced);
-		fdc        = malloc(sizeof(int) * cpualloced);
+		pgs        = calloc(cpualloced * NPERFGRPS,
+						sizeof(struct perfgroup));
+
+		ptrverify(pgs, "Malloc failed for perf event groups\n");
 
 		/*
-		** fill perf_event_attr struct with appropriate values
+		** fill perf_event_attr struct with appropriate values;
+		** all counters of a group are read at once via the group
+		** leader, including the time that the group was enabled
+		** and actually counting (only differs for the extra
+		** group when it has to share the hardware counters)
 		*/
 		memset(&pea, 0, sizeof(struct perf_event_attr));
 
-		pea.type    = PERF_TYPE_HARDWARE;
-		pea.size    = sizeof(struct perf_event_attr);
-		pea.inherit = 1;
-		pea.pinned  = 1;
+		pea.type        = PERF_TYPE_HARDWARE;
+		pea.size        = sizeof(struct perf_event_attr);
+		pea.read_format = PERF_FORMAT_GROUP |	// no inherit then
+		                  PERF_FORMAT_TOTAL_TIME_ENABLED |
+		                  PERF_FORMAT_TOTAL_TIME_RUNNING;
 
 	 	regainrootprivs();
 
-		for (i=0; i < cpualloced; i++)
+		for (i=0, pg=pgs; i < cpualloced * NPERFGRPS; i++, pg++)
 		{
-			pea.config = PERF_COUNT_HW_INSTRUCTIONS;
+			g = i % NPERFGRPS;
+
+			for (ev=0; ev < NPERFEVS; ev++)
+			{
+				pg->fds[ev] = -1;
+
+				if (!perfevs[ev].selected || perfevs[ev].group != g)
+					continue;
 
-			if ( (*(fdi+i) = perf_event_open(&pea, -1, i, -1,
- 						PERF_FLAG_FD_CLOEXEC)) >= 0)
-				success++;
+				pea.config = perfevs[ev].config;
+				pea.pinned = g == 0 && pg->nmembers == 0;
 
-                        pea.config = PERF_COUNT_HW_CPU_CYCLES;
+				pg->fds[ev] = perf_event_open(&pea, -1,
+					i / NPERFGRPS,
+					pg->nmembers ? pg->fds[pg->member[0]] : -1,
+					PERF_FLAG_FD_CLOEXEC);
 
-			if ( (*(fdc+i) = perf_event_open(&pea, -1, i, -1,
-						PERF_FLAG_FD_CLOEXEC)) >= 0)
-				success++;
+				if (pg->fds[ev] >= 0)
+				{
+					pg->member[pg->nmembers++] = ev;
+					success++;
+				}
+			}
 		}
 
 		if (! droprootprivs())
@@ -2940,8 +3172,7 @@ getperfevents(struct cpustat *cs)
 		*/
 		if (success == 0)	
 		{
-			free(fdi);
-			free(fdc);
+			free(pgs);
 			cpualloced = 0;
 		}
 		else
@@ -2960,46 +3191,64 @@ getperfevents(struct cpustat *cs)
                 return;
 
 	/*
-   	** retrieve counters per CPU and in total
+   	** retrieve counters per CPU (one read per group) and in total
 	*/
-	cs->all.instr = 0;
-	cs->all.cycle = 0;
+	for (ev=0; ev < NPERFEVS; ev++)
+		PERFCNT(&cs->all, ev) = 0;
 
-        for (i=0; i < cpualloced; i++)
+        for (i=0, pg=pgs; i < cpualloced * NPERFGRPS; i++, pg++)
         {
-		if (*(fdi+i) != -1)
+		if (pg->nmembers == 0)
+			continue;
+
+               	liResult = read(pg->fds[pg->member[0]], buf,
+					(3 + pg->nmembers) * sizeof(count_t));
+
+		if (liResult < 0)
 		{
-                	liResult = read(*(fdi+i), &(cs->cpu[i].instr), sizeof(count_t));
+			char lcMessage[64];
 
-			if(liResult < 0)
-			{
-				char lcMessage[64];
+			snprintf(lcMessage, sizeof(lcMessage) - 1,
+			          "%s:%d - Error %d reading perf counters\n",
+			           __FILE__, __LINE__, errno);
+			fprintf(stderr, "%s", lcMessage);
+			continue;
+		}
 
-				snprintf(lcMessage, sizeof(lcMessage) - 1,
-				          "%s:%d - Error %d reading instr counters\n",
-				           __FILE__, __LINE__, errno);
-				fprintf(stderr, "%s", lcMessage);
-			}
-			else
-			{
-                        	cs->all.instr += cs->cpu[i].instr;
-			}
+		/*
+		** a group that can not be scheduled (e.g. not enough
+		** hardware counters) is in error state and returns
+		** no values
+		*/
+		if (liResult < (3 + pg->nmembers) * sizeof(count_t))
+			continue;
+
+		/*
+		** extrapolate the values of a group that only counted
+		** part of the interval (multiplexed) with the ratio of
+		** this interval, and accumulate them to keep the
+		** counters monotonic
+		*/
+		enabled = buf[1] - pg->enabled;
+		running = buf[2] - pg->running;
 
-                	liResult = read(*(fdc+i), &(cs->cpu[i].cycle), sizeof(count_t));
+		pg->enabled = buf[1];
+		pg->running = buf[2];
 
-			if(liResult < 0)
-			{
-				char lcMessage[64];
+		for (j=0; j < pg->nmembers && j < buf[0]; j++)
+		{
+			ev  = pg->member[j];
+			val = buf[3+j] - pg->value[j];
 
-				snprintf(lcMessage, sizeof(lcMessage) - 1,
-				          "%s:%d - Error %d reading cycle counters\n",
-				           __FILE__, __LINE__, errno );
-				fprintf(stderr, "%s", lcMessage);
-			}
-			else
-			{
-                        	cs->all.cycle += cs->cpu[i].cycle;
-			}
+			pg->value[j] = buf[3+j];
+
+			if (running && running < enabled)
+				val = (double)val * enabled / running;
+
+			pg->scaled[j] += val;
+
+			PERFCNT(&cs->cpu[i / NPERFGRPS], ev)  = pg->scaled[j];
+			PERFCNT(&cs->all,                ev) += pg->scaled[j];
 		}
         }
 }
@@ -3011,4 +3260,10 @@ do_perfevents(char *tagname, char *tagvalue)
 	if (strcmp("disable", tagvalue))
 		mcleanstop(1, "atop built with NOPERFEVENT, cannot use perfevents\n");
 }
+
+void
+do_perfextra(char *tagname, char *tagvalue)
+{
+	mcleanstop(1, "atop built with NOPERFEVENT, cannot use perfextra\n");
+}
 #endif
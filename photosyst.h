@@ -189,7 +189,10 @@ struct percpu {
         struct freqcnt	freqcnt;/* frequency scaling info  		*/
 	count_t		instr;	/* CPU instructions 			*/
 	count_t		cycle;	/* CPU cycles 				*/
-	count_t		cfuture[6];	/* reserved for future use	*/
+	count_t		cachemiss;  /* last-level cache misses (perfextra) */
+	count_t		branchmiss; /* branch mispredictions   (perfextra) */
+	count_t		stalled;    /* stalled cycles backend  (perfextra) */
+	count_t		cfuture[3];	/* reserved for future use	*/
 };
 
 struct	cpustat {
@@ -467,10 +470,15 @@ void	photosyst (struct sstat *);
 void	deviatsyst(struct sstat *, struct sstat *, struct sstat *, long);
 void	totalsyst (char,           struct sstat *, struct sstat *);
 void	do_perfevents(char *, char *);
+void	do_perfextra(char *, char *);
 int     isdisk_major(unsigned int);
 void	realnuma_support(void);
 void	zswap_support(void);
 
+void	clearsstat(struct sstat *);
+size_t	packsstat(struct sstat *, char *);
+int	unpacksstat(char *, size_t, struct sstat *);
+
 /*
 ** return value of isdisk_...()
 */
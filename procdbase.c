@@ -5,9 +5,10 @@
 ** the system on system-level as well as process-level.
 ** 
 ** This source-file contains all functions required to manipulate the
-** process-database. This database is implemented as a linked list of
+** process-database. This database is implemented as a hash table of
 ** all running processes, needed to remember the process-counters from
-** the previous sample.
+** the previous sample, with a secondary index on the processes that
+** were not referred during the current sample.
 ** ==========================================================================
 ** Author:      Gerlof Langeveld
 ** E-mail:      gerlof.langeveld@atoptool.nl
@@ -39,24 +40,115 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <string.h>
+#include <stdlib.h>
 #include <malloc.h>
 
 #include "atop.h"
 #include "photoproc.h"
 
 /*****************************************************************************/
-#define	NPHASH	256		/* number of hash queues for process dbase   */
-				/* MUST be a power of 2 !!!                  */
+/*
+** The process database is an open-addressing hash table (linear probing)
+** keyed on the PID and the process/thread indication. The key fields
+** are stored in the slot itself, so a lookup only touches the slots in
+** its probe sequence (mostly one cache line) and not the process-info
+** structures. The table is doubled in size when it is filled for more
+** than half, and removed entries are filled by moving up subsequent
+** entries of the same probe sequence (no tombstones).
+*/
+#define	PDBINITSIZE	1024	/* initial number of slots (power of 2)	     */
+
+struct pdbslot {
+	int		pid;		/* process id or thread id	     */
+	char		isproc;		/* process-level or thread	     */
+	time_t		btime;		/* start time of task		     */
+	struct pinfo	*pinfo;		/* process-info or NULL (free slot)  */
+};
 
-	/* hash buckets for getting process-info     */
-	/* for a given PID 			     */
-static struct pinfo	*phash[NPHASH];
+static struct pdbslot	*ptable;	/* table with slots		     */
+static unsigned long	 ptsize;	/* number of slots (power of 2)      */
+static unsigned long	 ptused;	/* number of slots in use	     */
 
 	/* cyclic list of all processes, to detect   */
 	/* which processes were not referred	     */
 static struct pinfo	presidue;
+
+/*
+** Index on the RESIDUE-list to match exited processes for which the
+** accounting record does not contain a PID, keyed on name, real uid,
+** real gid and start time. The index is only built when such exited
+** process is searched for the first time after the RESIDUE-list has
+** been made, and the buckets are chained via the process-info structs.
+*/
+#define	RIDXMINSIZE	64	/* minimum number of buckets (power of 2)    */
+
+static struct pinfo	**ridxtable;	/* buckets of residue index	     */
+static unsigned long	  ridxsize;	/* number of buckets (power of 2)    */
+static char		  ridxbuilt;	/* index valid for RESIDUE-list?     */
+
+/*
+** The process-info structs are allocated in slabs that are never
+** freed; the structs of tasks that disappeared are kept in a free list
+** (chained via prnext) to be reused for new tasks, to avoid that the
+** heap gets fragmented with a high process churn.
+*/
+#define	PDBSLABSIZE	128	/* process-info structs per slab	     */
+
+static struct pinfo	*pfreelist;	/* free process-info structs	     */
+
+static unsigned long	pdb_home(int, char);
+static long		pdb_findslot(int, char, time_t);
+static void		pdb_delslot(unsigned long);
+static void		pdb_resize(unsigned long);
+static void		pdb_unresidue(struct pinfo *);
+static unsigned long	pdb_ridxhash(struct gen *, time_t);
+static void		pdb_ridxbuild(void);
 /*****************************************************************************/
 
+/*
+** determine the first slot of the probe sequence for a task
+** (multiplicative hashing to spread consecutive PIDs)
+*/
+static inline unsigned long
+pdb_home(int pid, char isproc)
+{
+	unsigned int	key = ((unsigned int)pid << 1) | (isproc != 0);
+
+	return (key * 2654435761U) & (ptsize - 1);
+}
+
+/*
+** search the slot of the given task
+**
+** with longer intervals, the same PID might be found more than once,
+** so also the start time of the task is checked (one second deviation
+** allowed, depending on the rounding of the boot time)
+**
+** return value: slot index or -1 (not found)
+*/
+static long
+pdb_findslot(int pid, char isproc, time_t btime)
+{
+	register struct pdbslot	*sp;
+	unsigned long		i;
+
+	if (!ptused)
+		return -1;
+
+	for (i = pdb_home(pid, isproc); (sp = &ptable[i])->pinfo;
+						i = (i+1) & (ptsize-1))
+	{
+		if (sp->pid == pid && sp->isproc == isproc)
+		{
+			long diff = sp->btime - btime;
+
+			if (diff <= 1 && diff >= -1)
+				return i;
+		}
+	}
+
+	return -1;
+}
 
 /*
 ** search process database for the given PID
@@ -65,55 +157,70 @@ int
 pdb_gettask(int pid, char isproc, time_t btime, struct pinfo **pinfopp)
 {
 	register struct pinfo	*pp;
+	long			i;
+
+	if ( (i = pdb_findslot(pid, isproc, btime)) == -1)
+		return 0;	/* PID not found */
 
-	pp = phash[pid&(NPHASH-1)];	/* get proper hash bucket	*/
+	pp = ptable[i].pinfo;
 
 	/*
-	** scan all entries in hash Q
+	** unchain it from the RESIDUE-list and return info
 	*/
-	while (pp)
-	{
-		/*
-		** if this is required PID, unchain it from the RESIDUE-list
-		** and return info
-		*/
-		if (pp->tstat.gen.pid    == pid    && 
-		    pp->tstat.gen.isproc == isproc   )
-		{
-			int diff = pp->tstat.gen.btime - btime;
-
-			/*
-			** with longer intervals, the same PID might be
-			** found more than once, so also check the start
-			** time of the task
-			*/
-			if (diff > 1 || diff < -1)
-			{
-				pp = pp->phnext;
-				continue;
-			}
+	pdb_unresidue(pp);
 
-			if (pp->prnext)		/* if part of RESIDUE-list   */
-			{
-				(pp->prnext)->prprev = pp->prprev; /* unchain */
-				(pp->prprev)->prnext = pp->prnext;
-			}
+	*pinfopp = pp;
 
-			pp->prnext = NULL;
-			pp->prprev = NULL;
+	return 1;
+}
 
-			*pinfopp = pp;
+/*
+** search process database for the given PID without
+** side effects on the RESIDUE-list (read-only lookup
+** that might be issued in parallel by multiple threads)
+*/
+int
+pdb_peektask(int pid, char isproc, time_t btime, struct pinfo **pinfopp)
+{
+	long	i;
 
-			return 1;
-		}
+	if ( (i = pdb_findslot(pid, isproc, btime)) == -1)
+		return 0;
+
+	*pinfopp = ptable[i].pinfo;
+
+	return 1;
+}
 
-		pp = pp->phnext;
+/*
+** obtain a zeroed process-info struct for a new task
+*/
+struct pinfo *
+pdb_newtask(void)
+{
+	register struct pinfo	*pp;
+	int			i;
+
+	if (!pfreelist)		/* no free structs left: allocate new slab */
+	{
+		pp = calloc(PDBSLABSIZE, sizeof(struct pinfo));
+
+		ptrverify(pp, "Malloc failed for slab of %d pinfo structs\n",
+								PDBSLABSIZE);
+
+		for (i=0; i < PDBSLABSIZE; i++, pp++)
+		{
+			pp->prnext = pfreelist;
+			pfreelist  = pp;
+		}
 	}
 
-	/*
-	** end of list; PID not found
-	*/
-	return 0;
+	pp        = pfreelist;
+	pfreelist = pp->prnext;
+
+	memset(pp, 0, sizeof *pp);
+
+	return pp;
 }
 
 /*
@@ -122,78 +229,113 @@ pdb_gettask(int pid, char isproc, time_t btime, struct pinfo **pinfopp)
 void
 pdb_addtask(int pid, struct pinfo *pinfop)
 {
-	register int i	= pid&(NPHASH-1);
+	unsigned long	i;
+
+	/*
+	** keep the table filled for at most one half
+	*/
+	if ((ptused+1) * 2 > ptsize)
+		pdb_resize(ptsize ? ptsize * 2 : PDBINITSIZE);
+
+	for (i = pdb_home(pid, pinfop->tstat.gen.isproc); ptable[i].pinfo;
+						i = (i+1) & (ptsize-1))
+		;
 
-	pinfop->phnext 	= phash[i];
-	phash[i] 	= pinfop;
+	ptable[i].pid    = pid;
+	ptable[i].isproc = pinfop->tstat.gen.isproc;
+	ptable[i].btime  = pinfop->tstat.gen.btime;
+	ptable[i].pinfo  = pinfop;
+
+	ptused++;
 }
 
 /*
 ** delete a process from the process database
 */
 int
-pdb_deltask(int pid, char isproc)
+pdb_deltask(int pid, char isproc, time_t btime)
 {
-	register struct pinfo	*pp, *ppp;
+	register struct pinfo	*pp;
+	long			i;
 
-	pp = phash[pid&(NPHASH-1)];	/* get proper hash bucket	*/
+	if ( (i = pdb_findslot(pid, isproc, btime)) == -1)
+		return 0;	/* PID not found */
+
+	pp = ptable[i].pinfo;
+
+	pdb_unresidue(pp);
+
+	pdb_delslot(i);
 
 	/*
-	** check first entry in hash Q
+	** remove process-info from process-database, close the
+	** cached descriptors of this task and keep the struct for reuse
 	*/
-	if (pp->tstat.gen.pid == pid && pp->tstat.gen.isproc == isproc)
-	{
-		phash[pid&(NPHASH-1)] = pp->phnext;
+	fdcache_evict(pid, isproc, pp->tstat.gen.btime);
 
-		if ( pp->prnext )	/* still part of RESIDUE-list ? */
-		{
-			(pp->prprev)->prnext = pp->prnext;
-			(pp->prnext)->prprev = pp->prprev;	/* unchain */
-		}
+	pp->prnext = pfreelist;
+	pfreelist  = pp;
 
-		/*
-		** remove process-info from process-database
-		*/
-		free(pp);
+	return 1;
+}
 
-		return 1;
-	}
+/*
+** free a slot and move up the subsequent entries of the probe
+** sequence that would not be found any more otherwise
+*/
+static void
+pdb_delslot(unsigned long i)
+{
+	unsigned long	j, home;
 
-	/*
-	** scan other entries of hash-list
-	*/
-	ppp	= pp;
-	pp	= pp->phnext;
+	ptused--;
 
-	while (pp)
+	for (j = (i+1) & (ptsize-1); ptable[j].pinfo; j = (j+1) & (ptsize-1))
 	{
+		home = pdb_home(ptable[j].pid, ptable[j].isproc);
+
 		/*
-		** if this is wanted PID, unchain it from the RESIDUE-list
-		** and return info
+		** the entry may stay when its home slot is
+		** cyclically located between the free slot and itself
 		*/
-		if (pp->tstat.gen.pid == pid && pp->tstat.gen.isproc == isproc)
-		{
-			ppp->phnext = pp->phnext;
+		if (i <= j ? (i < home && home <= j) : (i < home || home <= j))
+			continue;
 
-			if ( pp->prnext )	/* part of RESIDUE-list ? */
-			{
-				(pp->prnext)->prprev = pp->prprev;
-				(pp->prprev)->prnext = pp->prnext;
-			}
+		ptable[i] = ptable[j];
+		i = j;
+	}
 
-			/*
-			** remove process-info from process-database
-			*/
-			free(pp);
+	ptable[i].pinfo = NULL;
+}
 
-			return 1;
-		}
+/*
+** rebuild the table with the given number of slots
+*/
+static void
+pdb_resize(unsigned long newsize)
+{
+	struct pdbslot	*oldtable = ptable;
+	unsigned long	oldsize   = ptsize, i, j;
+
+	ptable = calloc(newsize, sizeof(struct pdbslot));
+	ptsize = newsize;
+
+	ptrverify(ptable, "Malloc failed for process database (%lu slots)\n",
+								newsize);
+
+	for (i=0; i < oldsize; i++)
+	{
+		if (!oldtable[i].pinfo)
+			continue;
+
+		for (j = pdb_home(oldtable[i].pid, oldtable[i].isproc);
+				ptable[j].pinfo; j = (j+1) & (ptsize-1))
+			;
 
-		ppp	= pp;
-		pp	= pp->phnext;
+		ptable[j] = oldtable[i];
 	}
 
-	return 0;	/* PID not found */
+	free(oldtable);
 }
 
 /*
@@ -207,7 +349,7 @@ int
 pdb_makeresidue(void)
 {
 	register struct pinfo	*pp, *pr;
-	register int		i;
+	register unsigned long	i;
 
 	/*
 	** prepare RESIDUE-list anchor
@@ -217,26 +359,21 @@ pdb_makeresidue(void)
 	pr->prnext	= pr;
 	pr->prprev	= pr;
 
+	ridxbuilt	= 0;	/* index to be rebuilt when needed */
+
 	/*
-	** check all entries in hash list
+	** check all slots in use
 	*/
-	for (i=0; i < NPHASH; i++)
+	for (i=0; i < ptsize; i++)
 	{
-		if (!phash[i])
-			continue;	/* empty hash bucket */
-
-		pp = phash[i];		/* get start of list */
+		if ( (pp = ptable[i].pinfo) == NULL)
+			continue;	/* free slot */
 
-		while (pp)		/* all entries in hash list	*/
-		{
-			pp->prnext		= pr->prnext;
-			pr->prnext		= pp;
+		pp->prnext		= pr->prnext;
+		pr->prnext		= pp;
 
-			 pp->prprev		= (pp->prnext)->prprev;
-			(pp->prnext)->prprev	= pp;
-
-			pp = pp->phnext;	/* get next of hash list */
-		}
+		 pp->prprev		= (pp->prnext)->prprev;
+		(pp->prnext)->prprev	= pp;
 	}
 
 	/*
@@ -245,6 +382,40 @@ pdb_makeresidue(void)
 	return 1;
 }
 
+/*
+** unchain a process-info struct from the RESIDUE-list
+** and from the residue index (if built)
+*/
+static void
+pdb_unresidue(struct pinfo *pp)
+{
+	struct pinfo	**ppp;
+
+	if (!pp->prnext)	/* not part of RESIDUE-list ? */
+		return;
+
+	(pp->prprev)->prnext = pp->prnext;
+	(pp->prnext)->prprev = pp->prprev;	/* unchain */
+
+	pp->prnext = NULL;
+	pp->prprev = NULL;
+
+	if (!ridxbuilt)
+		return;
+
+	for (ppp = &ridxtable[pdb_ridxhash(&pp->tstat.gen, pp->tstat.gen.btime)];
+						*ppp; ppp = &(*ppp)->prhnext)
+	{
+		if (*ppp == pp)
+		{
+			*ppp = pp->prhnext;
+			break;
+		}
+	}
+
+	pp->prhnext = NULL;
+}
+
 /*
 ** remove all remaining entries in RESIDUE-list
 */
@@ -254,6 +425,7 @@ pdb_cleanresidue(void)
 	register struct pinfo	*pr;
 	register int		pid;
         char			isproc;
+	time_t			btime;
 
 	/*
 	** start at RESIDUE-list anchor and delete all entries
@@ -264,15 +436,76 @@ pdb_cleanresidue(void)
 	{
 		pid    = pr->tstat.gen.pid;
 		isproc = pr->tstat.gen.isproc;
+		btime  = pr->tstat.gen.btime;
 
 		pr  = pr->prnext;	/* MUST be done before deletion */
 
-		pdb_deltask(pid, isproc);
+		pdb_deltask(pid, isproc, btime);
 	}
 
 	return 1;
 }
 
+/*
+** determine the bucket in the residue index for
+** the given name, real uid, real gid and start time
+*/
+static unsigned long
+pdb_ridxhash(struct gen *genp, time_t btime)
+{
+	unsigned long	hash = 14695981039346656037UL;
+	const char	*p;
+
+	for (p = genp->name; *p; p++)
+		hash = (hash ^ (unsigned char)*p) * 1099511628211UL;
+
+	hash = (hash ^ (unsigned int)genp->ruid)  * 1099511628211UL;
+	hash = (hash ^ (unsigned int)genp->rgid)  * 1099511628211UL;
+	hash = (hash ^ (unsigned long)btime)      * 1099511628211UL;
+
+	return (hash ^ (hash >> 32)) & (ridxsize - 1);
+}
+
+/*
+** build the residue index for all entries in the RESIDUE-list
+** (enlarge the bucket array when needed)
+*/
+static void
+pdb_ridxbuild(void)
+{
+	register struct pinfo	*pr;
+	unsigned long		nresidue = 0, newsize, h;
+
+	for (pr = presidue.prnext; pr != &presidue; pr = pr->prnext)
+		nresidue++;
+
+	for (newsize = RIDXMINSIZE; newsize < nresidue; newsize *= 2)
+		;
+
+	if (newsize > ridxsize)
+	{
+		free(ridxtable);
+
+		ridxtable = malloc(newsize * sizeof(struct pinfo *));
+		ridxsize  = newsize;
+
+		ptrverify(ridxtable,
+			"Malloc failed for residue index (%lu buckets)\n",
+			newsize);
+	}
+
+	memset(ridxtable, 0, ridxsize * sizeof(struct pinfo *));
+
+	for (pr = presidue.prnext; pr != &presidue; pr = pr->prnext)
+	{
+		h             = pdb_ridxhash(&pr->tstat.gen, pr->tstat.gen.btime);
+		pr->prhnext   = ridxtable[h];
+		ridxtable[h]  = pr;
+	}
+
+	ridxbuilt = 1;
+}
+
 /*
 ** search in the RESIDUE-list for process-info which may fit to the
 ** given process-info, for which the PID is not known
@@ -280,56 +513,39 @@ pdb_cleanresidue(void)
 int
 pdb_srchresidue(struct tstat *tstatp, struct pinfo **pinfopp)
 {
-	register struct pinfo	*pr, *prmin=NULL;
-	register long		btimediff;
+	register struct pinfo	*pr;
+	static const int	btimediff[] = {0, -1, 1};
+	time_t			btime;
+	unsigned int		i;
+
+	if (!ridxbuilt)
+		pdb_ridxbuild();
 
 	/*
-	** start at RESIDUE-list anchor and search through
-	** all remaining entries
+	** check if the start-time of the process is exactly
+	** the same ----> then we have a match;
+	** however sometimes the start-time may deviate a
+	** second although it IS the process we are looking
+	** for (depending on the rounding of the boot-time),
+	** so if we don't find the exact match, we will check
+	** if we find an almost-exact match
 	*/
-	pr = presidue.prnext;
-
-	while (pr != &presidue)	/* still entries left ? */
+	for (i=0; i < sizeof btimediff / sizeof btimediff[0]; i++)
 	{
-		/*
-		** check if this entry matches searched info
-		*/
-		if ( 	pr->tstat.gen.ruid   == tstatp->gen.ruid	&& 
-			pr->tstat.gen.rgid   == tstatp->gen.rgid	&& 
-			strcmp(pr->tstat.gen.name, tstatp->gen.name) == EQ  )
+		btime = tstatp->gen.btime + btimediff[i];
+
+		for (pr = ridxtable[pdb_ridxhash(&tstatp->gen, btime)]; pr;
+							pr = pr->prhnext)
 		{
-			/*
-			** check if the start-time of the process is exactly
-			** the same ----> then we have a match;
-			** however sometimes the start-time may deviate a
-			** second although it IS the process we are looking
-			** for (depending on the rounding of the boot-time),
-			** so if we don't find the exact match, we will check
-			** later on if we found an almost-exact match
-			*/
-			btimediff = pr->tstat.gen.btime - tstatp->gen.btime;
-
-			if (btimediff == 0)	/* gotcha !! */
+			if ( 	pr->tstat.gen.btime  == btime			&&
+				pr->tstat.gen.ruid   == tstatp->gen.ruid	&& 
+				pr->tstat.gen.rgid   == tstatp->gen.rgid	&& 
+				strcmp(pr->tstat.gen.name, tstatp->gen.name) == EQ  )
 			{
 				*pinfopp = pr;
 				return 1;
 			}
-
-			if ((btimediff== -1 || btimediff== 1) && prmin== NULL)
-				prmin = pr;	/* remember this process */
 		}
-
-		pr = pr->prnext;
-	}
-
-	/*
-	** nothing found that matched exactly;
-	** do we remember a process that matched almost exactly?
-	*/
-	if (prmin)
-	{
-		*pinfopp = prmin;
-		return 1;
 	}
 
 	return 0;	/* even not almost */
@@ -0,0 +1,376 @@
+/*
+** ATOP - System & Process Monitor
+**
+** The program 'atop' offers the possibility to view the activity of
+** the system on system-level as well as process-/thread-level.
+**
+** This source-file contains the parsers of the files stat, status, io
+** and schedstat of a process or thread, that have been read into a
+** buffer by the caller. The values are extracted in one pass with a
+** dedicated decimal scanner instead of sscanf().
+** ==========================================================================
+**
+** This program is free software; you can redistribute it and/or modify it
+** under the terms of the GNU General Public License as published by the
+** Free Software Foundation; either version 2, or (at your option) any
+** later version.
+**
+** This program is distributed in the hope that it will be useful, but
+** WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU General Public License for more details.
+*/
+
+#include <sys/types.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "atop.h"
+#include "photoproc.h"
+#include "procparse.h"
+
+/*
+** convert the decimal number at *pp (optionally preceded by
+** spaces/tabs and a minus sign) and move *pp beyond this number
+*/
+static inline count_t
+scannum(char **pp)
+{
+	register char		*p = *pp;
+	register count_t	val = 0;
+	int			neg = 0;
+
+	while (*p == ' ' || *p == '\t')
+		p++;
+
+	if (*p == '-')
+	{
+		neg = 1;
+		p++;
+	}
+
+	while (*p >= '0' && *p <= '9')
+		val = val * 10 + (*p++ - '0');
+
+	*pp = p;
+
+	return neg ? -val : val;
+}
+
+/*
+** move beyond the next space-separated field
+** returns: pointer to next field or NULL at end of string
+*/
+static inline char *
+skipfield(char *p)
+{
+	while (*p == ' ')
+		p++;
+
+	if (*p == '\0' || *p == '\n')
+		return NULL;
+
+	while (*p && *p != ' ' && *p != '\n')
+		p++;
+
+	return p;
+}
+
+/*
+** parse the contents of file "stat"
+**
+** returns: 1 when parsed, 0 when the contents are not complete
+*/
+int
+parsestat(struct tstat *curtask, char *line,
+				unsigned long long bootepoch, char isproc)
+{
+	int	nr, field;
+	char	*p, *cmdhead, *cmdtail;
+
+	/*
+    	** fetch command name
+	*/
+	cmdhead = strchr (line, '(');
+	cmdtail = strrchr(line, ')');
+
+	if (!cmdhead || !cmdtail || cmdtail < cmdhead) // parsing failed?
+		return 0;
+
+	if ( (nr = cmdtail-cmdhead-1) > PNAMLEN)
+		nr = PNAMLEN;
+
+	p = curtask->gen.name;
+
+	memcpy(p, cmdhead+1, nr);
+	*(p+nr) = 0;
+
+	while ( (p = strchr(p, '\n')) != NULL)
+	{
+		*p = '?';
+		p++;
+	}
+
+	/*
+  	** fetch other values
+  	*/
+	curtask->gen.isproc  = isproc;
+	curtask->cpu.rtprio  = 0;
+	curtask->cpu.policy  = 0;
+	curtask->gen.excode  = 0;
+
+	p = line;
+	curtask->gen.pid = scannum(&p);		/* fetch pid */
+
+	/*
+	** the fields after the command name are numbered from 3
+	** onwards (see proc(5)); every field is either converted
+	** or skipped in one pass over the line
+	*/
+	if (*(cmdtail+1) != ' ' || *(cmdtail+2) == '\0')
+		return 0;
+
+	curtask->gen.state = *(cmdtail+2);
+
+	for (p=cmdtail+3, field=4; field <= 42; field++)
+	{
+		while (*p == ' ')
+			p++;
+
+		if (*p == '\0' || *p == '\n')	// premature end of line?
+			break;
+
+		switch (field)
+		{
+		   case 4:
+			curtask->gen.ppid      = scannum(&p);
+			break;
+		   case 10:
+			curtask->mem.minflt    = scannum(&p);
+			break;
+		   case 12:
+			curtask->mem.majflt    = scannum(&p);
+			break;
+		   case 14:
+			curtask->cpu.utime     = scannum(&p);
+			break;
+		   case 15:
+			curtask->cpu.stime     = scannum(&p);
+			break;
+		   case 18:
+			curtask->cpu.prio      = scannum(&p);
+			break;
+		   case 19:
+			curtask->cpu.nice      = scannum(&p);
+			break;
+		   case 22:
+			curtask->gen.btime     = scannum(&p);
+			break;
+		   case 23:
+			curtask->mem.vmem      = scannum(&p);
+			break;
+		   case 24:
+			curtask->mem.rmem      = scannum(&p);
+			break;
+		   case 39:
+			curtask->cpu.curcpu    = scannum(&p);
+			break;
+		   case 40:
+			curtask->cpu.rtprio    = scannum(&p);
+			break;
+		   case 41:
+			curtask->cpu.policy    = scannum(&p);
+			break;
+		   case 42:
+			curtask->cpu.blkdelay  = scannum(&p);
+			break;
+		   default:
+			p = skipfield(p);
+		}
+	}
+
+	if (field <= 39)		/* parsing failed? */
+		return 0;
+
+	/*
+ 	** normalization
+	*/
+	curtask->gen.btime   = (curtask->gen.btime+bootepoch)/hertz;
+	curtask->cpu.prio   += 100; 	/* was subtracted by kernel */
+	curtask->mem.vmem   /= 1024;
+	curtask->mem.rmem   *= pagesize/1024;
+
+	switch (curtask->gen.state)
+	{
+  	   case 'R':
+		curtask->gen.nthrrun  = 1;
+		break;
+  	   case 'S':
+		curtask->gen.nthrslpi = 1;
+		break;
+  	   case 'D':
+		curtask->gen.nthrslpu = 1;
+		break;
+	   case 'I':
+		curtask->gen.nthridle = 1;
+		break;
+	}
+
+	return 1;
+}
+
+/*
+** check if the line starts with the given key (string constant
+** including colon) and move the pointer beyond that key
+*/
+#define	ISKEY(p, key)	(memcmp((p), key, sizeof key - 1) == 0 && \
+				((p) += sizeof key - 1))
+
+/*
+** parse the contents of file "status"
+*/
+void
+parsestatus(struct tstat *curtask, char *buf)
+{
+	char	*p, *eol;
+
+	curtask->gen.nthr     = 1;	/* for compat with 2.4 */
+	curtask->cpu.sleepavg = 0;	/* for compat with 2.4 */
+	curtask->mem.vgrow    = 0;	/* calculated later */
+	curtask->mem.rgrow    = 0;	/* calculated later */
+
+	/*
+	** handle the file line by line; the first character
+	** of the line selects the keys to be compared
+	*/
+	for (p=buf; *p; p = eol+1)
+	{
+		if ( (eol = strchr(p, '\n')) == NULL)
+			eol = p + strlen(p) - 1;
+
+		switch (*p)
+		{
+		   case 'T':
+			if (ISKEY(p, "Tgid:"))
+				curtask->gen.tgid = scannum(&p);
+			else if (ISKEY(p, "Threads:"))
+				curtask->gen.nthr = scannum(&p);
+			break;
+
+		   case 'P':
+			if (ISKEY(p, "Pid:"))
+				curtask->gen.pid = scannum(&p);
+			break;
+
+		   case 'S':
+			if (ISKEY(p, "SleepAVG:"))
+				curtask->cpu.sleepavg = scannum(&p);
+			break;
+
+		   case 'U':
+			if (ISKEY(p, "Uid:"))
+			{
+				curtask->gen.ruid  = scannum(&p);
+				curtask->gen.euid  = scannum(&p);
+				curtask->gen.suid  = scannum(&p);
+				curtask->gen.fsuid = scannum(&p);
+			}
+			break;
+
+		   case 'G':
+			if (ISKEY(p, "Gid:"))
+			{
+				curtask->gen.rgid  = scannum(&p);
+				curtask->gen.egid  = scannum(&p);
+				curtask->gen.sgid  = scannum(&p);
+				curtask->gen.fsgid = scannum(&p);
+			}
+			break;
+
+		   case 'e':
+			if (ISKEY(p, "envID:"))
+				curtask->gen.ctid = scannum(&p);
+			break;
+
+		   case 'V':
+			if (*(p+1) == 'P')
+			{
+				if (ISKEY(p, "VPid:"))
+					curtask->gen.vpid = scannum(&p);
+				break;
+			}
+
+			if (*(p+1) != 'm')
+				break;
+
+			if (ISKEY(p, "VmData:"))
+				curtask->mem.vdata  = scannum(&p);
+			else if (ISKEY(p, "VmStk:"))
+				curtask->mem.vstack = scannum(&p);
+			else if (ISKEY(p, "VmExe:"))
+				curtask->mem.vexec  = scannum(&p);
+			else if (ISKEY(p, "VmLib:"))
+				curtask->mem.vlibs  = scannum(&p);
+			else if (ISKEY(p, "VmSwap:"))
+				curtask->mem.vswap  = scannum(&p);
+			else if (ISKEY(p, "VmLck:"))
+				curtask->mem.vlock  = scannum(&p);
+			break;
+
+		   case 'v':
+			if (ISKEY(p, "voluntary_ctxt_switches:"))
+				curtask->cpu.nvcsw  = scannum(&p);
+			break;
+
+		   case 'n':
+			if (ISKEY(p, "nonvoluntary_ctxt_switches:"))
+				curtask->cpu.nivcsw = scannum(&p);
+			break;
+		}
+	}
+}
+
+/*
+** parse the contents of file "io" (>= 2.6.20)
+*/
+void
+parseio(struct tstat *curtask, char *buf)
+{
+	char	*p, *eol;
+	count_t	dskrsz=0, dskwsz=0, dskcwsz=0;
+
+	for (p=buf; *p; p = eol+1)
+	{
+		if ( (eol = strchr(p, '\n')) == NULL)
+			eol = p + strlen(p) - 1;
+
+		if (ISKEY(p, "read_bytes:"))
+			dskrsz  = scannum(&p) / 512;  // sectors
+		else if (ISKEY(p, "write_bytes:"))
+			dskwsz  = scannum(&p) / 512;  // sectors
+		else if (ISKEY(p, "cancelled_write_bytes:"))
+			dskcwsz = scannum(&p) / 512;  // sectors
+	}
+
+	curtask->dsk.rsz	= dskrsz;
+	curtask->dsk.rio	= dskrsz;  // to enable sort
+	curtask->dsk.wsz	= dskwsz;
+	curtask->dsk.wio	= dskwsz;  // to enable sort
+	curtask->dsk.cwsz	= dskcwsz;
+}
+
+/*
+** parse the contents of file "schedstat": runtime rundelay pcount
+**
+** returns: run delay
+*/
+count_t
+parseschedstat(char *buf)
+{
+	char	*p = buf;
+
+	(void) scannum(&p);		// skip runtime
+
+	return scannum(&p);
+}
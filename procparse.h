@@ -0,0 +1,30 @@
+/*
+** ATOP - System & Process Monitor
+**
+** The program 'atop' offers the possibility to view the activity of
+** the system on system-level as well as process-/thread-level.
+**
+** Include-file describing the parsers of the files stat, status, io
+** and schedstat of a process or thread.
+** ==========================================================================
+**
+** This program is free software; you can redistribute it and/or modify it
+** under the terms of the GNU General Public License as published by the
+** Free Software Foundation; either version 2, or (at your option) any
+** later version.
+**
+** This program is distributed in the hope that it will be useful, but
+** WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU General Public License for more details.
+*/
+
+#ifndef __PROCPARSE__
+#define __PROCPARSE__
+
+int		parsestat(struct tstat *, char *, unsigned long long, char);
+void		parsestatus(struct tstat *, char *);
+void		parseio(struct tstat *, char *);
+count_t		parseschedstat(char *);
+
+#endif
@@ -58,11 +58,12 @@
 #include "cgroups.h"
 #include "showgeneric.h"
 #include "rawlog.h"
+#include "stagecost.h"
 
 #define	BASEPATH	"/var/log/atop"  
 
 static int	getrawrec  (int, struct rawrecord *, int, int);
-static int	getrawsstat(int, struct sstat *, int);
+static int	getrawsstat(int, struct sstat *, int, int, int);
 static int	getrawtstat(int, struct tstat *, int, int);
 static int	getrawcstat(int, struct cgchainer **,
 			unsigned long, unsigned long,
@@ -81,17 +82,22 @@ char
 rawwrite(time_t curtime, int numsecs, 
          struct devtstat *devtstat, struct sstat *sstat,
 	 struct cgchainer *devchain, int ncgroups, int npids,
-         int nexit, unsigned int noverflow, char flag)
+         int nexit, unsigned int noverflow, int flag)
 {
 	static int		rawfd = -1;
 	struct rawrecord	rr;
 	int			rv;
 	struct stat		filestat;
+	char			procsample;
+	struct stgmark		stgmark;
 
-	Byte			scompbuf[sizeof(struct sstat)], *pcompbuf,
+	static char		spackbuf[sizeof(struct sstat) +
+				         sizeof(struct stagecost)];
+	Byte			scompbuf[sizeof(struct sstat) +
+				         sizeof(struct stagecost)], *pcompbuf,
 				*ccompbuf = NULL, *icompbuf = NULL;
 
-	unsigned long		soriglen = sizeof scompbuf, scomplen = compressBound(soriglen),
+	unsigned long		soriglen, scomplen = sizeof scompbuf,
 				poriglen, pcomplen,
 				coriglen, ccomplen,
 				ioriglen, icomplen;
@@ -106,6 +112,8 @@ rawwrite(time_t curtime, int numsecs,
 	if (rawfd == -1)
 		rawfd = rawwopen();
 
+	stgstart(&stgmark, 0);
+
 	/*
  	** register current size of file in order to "roll back"
 	** writes that have been done while not *all* writes could
@@ -114,16 +122,30 @@ rawwrite(time_t curtime, int numsecs,
 	(void) fstat(rawfd, &filestat);
 
 	/*
-	** compress system level metrics
+	** compress system level metrics, only storing the
+	** array entries that are in use (packed representation),
+	** followed by the costs of atop itself per stage
 	*/
-	rv = compress(scompbuf, &scomplen, (Byte *)sstat, soriglen);
+	soriglen = packsstat(sstat, spackbuf);
+
+	memcpy(spackbuf + soriglen, &stagecost, sizeof stagecost);
+	soriglen += sizeof stagecost;
+
+	rv = compress(scompbuf, &scomplen, (Byte *)spackbuf, soriglen);
 
 	testcompval(rv, "compress system stats");
 
+	/*
+	** the process-level and cgroup-level metrics are only
+	** stored when they have been gathered during this sample
+	** (see 'procinterval')
+	*/
+	procsample = !(flag & RRNOPROC);
+
 	/*
 	** compress process level metrics
 	*/
-	poriglen = sizeof(struct tstat) * devtstat->ntaskall;
+	poriglen = procsample ? sizeof(struct tstat) * devtstat->ntaskall : 0;
 	pcomplen = compressBound(poriglen);
 
 	pcompbuf = malloc(pcomplen);
@@ -137,7 +159,7 @@ rawwrite(time_t curtime, int numsecs,
 	/*
 	** compress cgroup level metrics
 	*/
-	if (supportflags & CGROUPV2)
+	if ((supportflags & CGROUPV2) && procsample)
 	{
 		/*
 		** calculate the size of all contiguous cstat structs
@@ -187,22 +209,34 @@ rawwrite(time_t curtime, int numsecs,
 
 	rr.curtime	= curtime;
 	rr.interval	= numsecs;
-	rr.flags	= 0;
-	rr.ndeviat	= devtstat->ntaskall;
-	rr.nactproc	= devtstat->nprocactive;
-	rr.ntask	= devtstat->ntaskall;
-	rr.nexit	= nexit;
-	rr.noverflow	= noverflow;
-	rr.totproc	= devtstat->nprocall;
-	rr.totrun	= devtstat->totrun;
-	rr.totslpi	= devtstat->totslpi;
-	rr.totslpu	= devtstat->totslpu;
-	rr.totidle	= devtstat->totidle;
-	rr.totzomb	= devtstat->totzombie;
-	rr.ncgroups	= ncgroups;
-	rr.ncgpids	= npids;
+	rr.flags	= RRPACKSSTAT|RRSTAGECOST;
 	rr.scomplen	= scomplen;
 	rr.pcomplen	= pcomplen;
+	rr.sampdelay	= sampdelay;
+	rr.sampcollect	= sampcollect;
+
+	if (procsample)
+	{
+		rr.pinterval	= devtstat->pinterval;
+		rr.ndeviat	= devtstat->ntaskall;
+		rr.nactproc	= devtstat->nprocactive;
+		rr.ntask	= devtstat->ntaskall;
+		rr.nexit	= nexit;
+		rr.noverflow	= noverflow;
+		rr.totproc	= devtstat->nprocall;
+		rr.totrun	= devtstat->totrun;
+		rr.totslpi	= devtstat->totslpi;
+		rr.totslpu	= devtstat->totslpu;
+		rr.totidle	= devtstat->totidle;
+		rr.totzomb	= devtstat->totzombie;
+		rr.ncgroups	= ncgroups;
+		rr.ncgpids	= npids;
+	}
+	else
+	{
+		rr.flags       |= RRNOPROC;
+	}
+
 	rr.ccomplen	= ccomplen;
 	rr.coriglen	= coriglen;
 	rr.icomplen	= icomplen;
@@ -222,7 +256,7 @@ rawwrite(time_t curtime, int numsecs,
 	if (supportflags & NETATOPD)
 		rr.flags |= RRNETATOPD;
 
-	if (supportflags & CGROUPV2)
+	if ((supportflags & CGROUPV2) && procsample)
 		rr.flags |= RRCGRSTAT;
 
 	if (supportflags & CONTAINERSTAT)
@@ -272,12 +306,14 @@ rawwrite(time_t curtime, int numsecs,
 
 	free(pcompbuf);
 
-	if (supportflags & CGROUPV2)
+	if ((supportflags & CGROUPV2) && procsample)
 	{
 		free(ccompbuf);
 		free(icompbuf);
 	}
 
+	stgstop(&stgmark, STGRAWW);	// stored with next sample
+
 	return '\0';
 }
 
@@ -324,7 +360,43 @@ rawwopen()
 				mcleanstop(7, "file %s exists but does not contain raw "
 					"atop output (wrong magic number)\n", orawname);
 
-			if ( rh.sstatlen	!= sizeof(struct sstat)		||
+			/*
+			** records of this version (e.g. with packed system-level
+			** counters) should not be appended to a raw file that
+			** might be read by the atop version that created it,
+			** so such file (e.g. after an upgrade during the day)
+			** is renamed with the version as suffix and a new raw
+			** file is started
+			*/
+			if ((rh.aversion & 0x7fff) != getnumvers())
+			{
+				char	oldname[RAWNAMESZ+16];
+
+				snprintf(oldname, sizeof oldname, "%s-%d.%d",
+					orawname,
+					(rh.aversion >> 8) & 0x7f,
+					 rh.aversion & 0xff);
+
+				if (link(orawname, oldname) == -1 ||
+				    unlink(orawname)        == -1   )
+				{
+					fprintf(stderr, "%s - ", oldname);
+					perror("rename existing raw file");
+					cleanstop(7);
+				}
+
+				fprintf(stderr, "existing file %s created by "
+					"version %d.%d - renamed to %s\n",
+					orawname,
+					(rh.aversion >> 8) & 0x7f,
+					 rh.aversion & 0xff, oldname);
+
+				close(fd);
+
+				return rawwopen();
+			}
+
+			if ( (rh.sstatlen & ~PACKEDSSTAT) != sizeof(struct sstat) ||
 			     rh.tstatlen	!= sizeof(struct tstat)		||
 			     rh.cstatlen	!= sizeof(struct cstat)		||
 		    	     rh.rawheadlen	!= sizeof(struct rawheader)	||
@@ -334,18 +406,6 @@ rawwopen()
 					"existing file %s has incompatible header\n",
 					orawname);
 
-				if (rh.aversion & 0x8000 &&
-				   (rh.aversion & 0x7fff) != getnumvers())
-				{
-					fprintf(stderr,
-						"(created by version %d.%d - "
-						"current version %d.%d)\n",
-						(rh.aversion >> 8) & 0x7f,
-						 rh.aversion & 0xff,
-						 getnumvers() >> 8,
-						 getnumvers() & 0x7f);
-				}
-
 				cleanstop(7);
 			}
 
@@ -410,7 +470,7 @@ rawwopen()
 
 	rh.magic	= MYMAGIC;
 	rh.aversion	= getnumvers() | 0x8000;
-	rh.sstatlen	= sizeof(struct sstat);
+	rh.sstatlen	= sizeof(struct sstat) | PACKEDSSTAT;
 	rh.tstatlen	= sizeof(struct tstat);
 	rh.cstatlen	= sizeof(struct cstat);
 	rh.rawheadlen	= sizeof(struct rawheader);
@@ -461,7 +521,8 @@ rawread(void)
 	off_t			*offlist = NULL;
 	unsigned int		offsize = 0;
 	unsigned int		offcur  = 0;
-	char			lastcmd = 'X', flags;
+	char			lastcmd = 'X';
+	int			flags;
 
 	time_t			timenow;
 	struct tm		*tp;
@@ -593,13 +654,14 @@ rawread(void)
 	/*
 	** magic okay, but file-layout might have been modified
 	*/
-	if (rh.sstatlen   != sizeof(struct sstat)		||
+	if ((rh.sstatlen & ~PACKEDSSTAT) != sizeof(struct sstat)	||
 	    rh.tstatlen   != sizeof(struct tstat)		||
 	    rh.cstatlen   != sizeof(struct cstat)		||
 	    rh.rawheadlen != sizeof(struct rawheader)		||
 	    rh.rawreclen  != sizeof(struct rawrecord)		  )
 	{
-		fprintf(stderr, "sstatlen: %d/%lu\n", rh.sstatlen, sizeof(struct sstat));
+		fprintf(stderr, "sstatlen: %d/%lu\n", rh.sstatlen & ~PACKEDSSTAT,
+							sizeof(struct sstat));
 		fprintf(stderr, "cstatlen: %d/%lu\n", rh.cstatlen, sizeof(struct cstat));
 		fprintf(stderr, "tstatlen: %d/%lu\n", rh.tstatlen, sizeof(struct tstat));
 		fprintf(stderr, "headlen:  %d/%lu\n", rh.rawheadlen, sizeof(struct rawheader));
@@ -630,6 +692,26 @@ rawread(void)
 		cleanstop(7);
 	}
 
+	/*
+	** layout identical, but the records of a newer version might
+	** contain information that is not understood by this version
+	*/
+	if (rh.aversion & 0x8000 &&
+	   (rh.aversion & 0x7fff) > getnumvers())
+	{
+		fprintf(stderr,
+			"raw file %s created by newer version %d.%d - "
+			"current version %d.%d\n", irawname,
+			(rh.aversion >> 8) & 0x7f,
+			 rh.aversion       & 0xff,
+			 getnumvers() >> 8,
+			 getnumvers() & 0x7f);
+
+		close(rawfd);
+
+		cleanstop(7);
+	}
+
 	memcpy(&utsname, &rh.utsname, sizeof utsname);
 	utsnodenamelen = strlen(utsname.nodename);
 
@@ -781,7 +863,9 @@ rawread(void)
 			** allocate space, read compressed system-level
 			** metrics and decompress
 			*/
-			if ( !getrawsstat(rawfd, &sstat, rr.scomplen) )
+			if ( !getrawsstat(rawfd, &sstat, rr.scomplen,
+						(rr.flags & RRPACKSSTAT),
+						(rr.flags & RRSTAGECOST)) )
 				cleanstop(7);
 
 			/*
@@ -842,6 +926,20 @@ rawread(void)
  			devtstat.totidle	= rr.totidle;
  			devtstat.totzombie	= rr.totzomb;
 
+			/*
+			** interval covered by the process-level deviations
+			** (0 in older raw files)
+			*/
+			devtstat.pinterval	= rr.pinterval ?
+							rr.pinterval : rr.interval;
+
+			/*
+			** latency of gathering this sample
+			** (0 in older raw files)
+			*/
+			sampdelay		= rr.sampdelay;
+			sampcollect		= rr.sampcollect;
+
 			/*
 			** allocate space, read compressed cgroup-level
 			** metrics, the pidlist and decompress
@@ -897,7 +995,7 @@ rawread(void)
 			else
 				supportflags &= ~GPUSTAT;
 
-			flags = rr.flags & RRBOOT;
+			flags = rr.flags & (RRBOOT|RRNOPROC);
 
 			nrgpus = sstat.gpu.nrgpus;
 
@@ -1033,12 +1131,15 @@ getrawrec(int rawfd, struct rawrecord *prr, int rrlen, int isregular)
 ** read the system-level statistics from the current offset
 */
 static int
-getrawsstat(int rawfd, struct sstat *sp, int complen)
+getrawsstat(int rawfd, struct sstat *sp, int complen, int packed,
+								int costs)
 {
-	Byte		*compbuf;
+	Byte		*compbuf, *origbuf = (Byte *)sp;
 	unsigned long	uncomplen = sizeof(struct sstat);
 	int		rv;
 
+	memset(&stagecost, 0, sizeof stagecost);
+
 	compbuf = malloc(complen);
 
 	ptrverify(compbuf, "Malloc failed for reading compressed sysstats\n");
@@ -1049,12 +1150,48 @@ getrawsstat(int rawfd, struct sstat *sp, int complen)
 		return 0;
 	}
 
-	rv = uncompress((Byte *)sp, &uncomplen, compbuf, complen);
+	/*
+	** packed representation (only array entries in use) is
+	** decompressed in a separate buffer and unpacked afterwards
+	*/
+	if (packed)
+	{
+		uncomplen = sizeof(struct sstat) + sizeof(struct stagecost);
+		origbuf   = malloc(uncomplen);
+
+		ptrverify(origbuf, "Malloc failed for unpacking sysstats\n");
+	}
+
+	rv = uncompress(origbuf, &uncomplen, compbuf, complen);
 
 	testcompval(rv, "uncompress");
 
 	free(compbuf);
 
+	if (packed)
+	{
+		/*
+		** the costs of atop itself per stage are
+		** stored behind the packed representation
+		*/
+		if (costs && uncomplen >= sizeof(struct stagecost))
+		{
+			uncomplen -= sizeof(struct stagecost);
+			memcpy(&stagecost, origbuf + uncomplen,
+						sizeof(struct stagecost));
+		}
+
+		rv = unpacksstat((char *)origbuf, uncomplen, sp);
+
+		free(origbuf);
+
+		if (!rv)
+		{
+			fprintf(stderr, "corrupt packed system-level statistics\n");
+			return 0;
+		}
+	}
+
 	return 1;
 }
 
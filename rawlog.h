@@ -49,6 +49,7 @@
 ** etcetera .....
 */
 #define	MYMAGIC		(unsigned int) 0xfeedbeef
+#define	PACKEDSSTAT	(unsigned int) 0x80000000	/* flag in sstatlen */
 #define READAHEADOFF	22
 #define READAHEADSIZE	(1 << READAHEADOFF)
 
@@ -64,6 +65,7 @@ struct rawheader {
 	unsigned short	pidwidth;	/* number of digits for PID/TID  */
 	unsigned short	sfuture[5];	/* future use                    */
 	unsigned int	sstatlen;	/* length of struct sstat        */
+					/* (PACKEDSSTAT: packed sstat)   */
 	unsigned int	tstatlen;	/* length of struct tstat        */
 	struct utsname	utsname;	/* info about this system        */
 	char		cfuture[8];	/* future use                    */
@@ -82,7 +84,8 @@ struct rawrecord {
 
 	unsigned short	flags;		/* various flags                */
 	unsigned short	ncgroups;	/* number of cgroups 		*/
-	unsigned short	sfuture[2];	/* future use                   */
+	unsigned short	sampdelay;	/* msecs scheduled till start   */
+	unsigned short	sampcollect;	/* msecs to gather the sample   */
 
 	unsigned int	scomplen;	/* length of compressed sstat   */
 	unsigned int	pcomplen;	/* length of compressed tstat's */
@@ -102,6 +105,7 @@ struct rawrecord {
 	unsigned int	coriglen;	/* length of original   cstats	*/
 	unsigned int	ncgpids;	/* number of cgroups pidlist 	*/
 	unsigned int	icomplen;	/* length of compressed pidlist */
-	unsigned int	ifuture;	/* future use                   */
+	unsigned int	pinterval;	/* interval process-level stats */
+					/* (0: same as interval)        */
 };
 #endif
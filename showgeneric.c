@@ -111,7 +111,7 @@ static long	getnumval(char *, long, int);
 static void	getsigwinch(int);
 static void	generic_init(void);
 static char	text_samp(time_t, int, struct devtstat *, struct sstat *,
-	   		struct cgchainer *, int, int, unsigned int, char);
+	   		struct cgchainer *, int, int, unsigned int, int);
 
 static int	(*procsort[])(const void *, const void *) = {
 			[MSORTCPU&0x1f]=compcpu, 
@@ -136,7 +136,7 @@ char
 generic_samp(time_t curtime, int nsecs,
            struct devtstat *devtstat, struct sstat *sstat,
 	   struct cgchainer *cstats, int ncgroups, int npids,
-           int nexit, unsigned int noverflow, char flag)
+           int nexit, unsigned int noverflow, int flag)
 {
 	static char	firstcall = 1;
 	char		retval, sorted = 0;
@@ -285,10 +285,11 @@ static char
 text_samp(time_t curtime, int nsecs,
            struct devtstat *devtstat, struct sstat *sstat, 
 	   struct cgchainer *cgchainers, int ncgroups,
-           int nexit, unsigned int noverflow, char flag)
+           int nexit, unsigned int noverflow, int flag)
 {
 	register int	i, curline, statline, nproc;
 	int		firstitem=0, slistsz, alistsz, killpid, killsig;
+	int		pnsecs;
 	int		lastchar;
 	char		format1[16], format2[16], branchtime[32];
 	char		*statmsg = NULL, statbuf[80], genline[80];
@@ -388,6 +389,15 @@ text_samp(time_t curtime, int nsecs,
 	*/
 	totalcap(&syscap, sstat, devtstat->procactive, devtstat->nprocactive);
 
+	/*
+	** the process-level and cgroup-level deviations might cover
+	** a longer interval than the system-level deviations (see
+	** 'procinterval'), so the available cpu capacity is scaled
+	*/
+	pnsecs = devtstat->pinterval > nsecs ? devtstat->pinterval : nsecs;
+
+	syscap.availcpu = syscap.availcpu * pnsecs / nsecs;
+
 	/*
 	** sort per-cpu       		statistics on busy percentage
 	** sort per-logical-volume      statistics on busy percentage
@@ -532,7 +542,7 @@ text_samp(time_t curtime, int nsecs,
 		/*
 		** print cumulative system- and user-time for all processes
 		*/
-		pricumproc(sstat, devtstat, nexit, noverflow, avgval, nsecs);
+		pricumproc(sstat, devtstat, nexit, noverflow, avgval, pnsecs);
 
 		if (noverflow)
 		{
@@ -1043,7 +1053,7 @@ text_samp(time_t curtime, int nsecs,
 				*/
 				priproc(curlist, firstitem, ncurlist, curline+2,
 				        firstitem/slistsz+1, (ncurlist-1)/slistsz+1,
-			        	showtype, curorder, &syscap, nsecs, avgval);
+			        	showtype, curorder, &syscap, pnsecs, avgval);
 			}
 		}
 		else	// MCGROUPS: print cgroups
@@ -1148,7 +1158,7 @@ text_samp(time_t curtime, int nsecs,
 				*/
 				pricgroup(cgroupsel, firstitem, ncurlist, curline+2,
 			        	firstitem/slistsz+1, (ncurlist-1)/slistsz+1,
-					&syscap, nsecs, avgval);
+					&syscap, pnsecs, avgval);
 			}
 		}
 
@@ -1620,7 +1630,7 @@ text_samp(time_t curtime, int nsecs,
 				move(statline, 0);
 
 				if (interval && !paused && !rawreadflag)
-					alarm(1); /* force new sample */
+					setalarm(1); /* force new sample */
 
 				firstitem = 0;
 
@@ -1677,7 +1687,7 @@ text_samp(time_t curtime, int nsecs,
 				}
 
 				if (!paused && !twinpid)
-					alarm(3); /* set short timer */
+					setalarm(3); /* set short timer */
 
 				firstitem = 0;
 
@@ -1710,7 +1720,7 @@ text_samp(time_t curtime, int nsecs,
 				if (interval)
 				{
 					if (!paused)
-						alarm(1); /* set short timer */
+						setalarm(1); /* set short timer */
 				}
 				else
 				{
@@ -1810,7 +1820,7 @@ text_samp(time_t curtime, int nsecs,
 				}
 
 				if (interval && !paused && !rawreadflag)
-					alarm(3);  /* set short timer */
+					setalarm(3);  /* set short timer */
 
 				firstitem = 0;
 
@@ -1859,7 +1869,7 @@ text_samp(time_t curtime, int nsecs,
 				move(statline, 0);
 
 				if (interval && !paused && !rawreadflag)
-					alarm(3);  /* set short timer */
+					setalarm(3);  /* set short timer */
 
 				firstitem = 0;
 
@@ -1914,7 +1924,7 @@ text_samp(time_t curtime, int nsecs,
 				move(statline, 0);
 
 				if (interval && !paused && !rawreadflag)
-					alarm(3);  /* set short timer */
+					setalarm(3);  /* set short timer */
 
 				firstitem = 0;
 
@@ -1979,7 +1989,7 @@ text_samp(time_t curtime, int nsecs,
 				move(statline, 0);
 
 				if (interval && !paused && !rawreadflag)
-					alarm(3);  /* set short timer */
+					setalarm(3);  /* set short timer */
 
 				firstitem = 0;
 
@@ -2062,7 +2072,7 @@ text_samp(time_t curtime, int nsecs,
 				move(statline, 0);
 
 				if (interval && !paused && !rawreadflag)
-					alarm(3);  /* set short timer */
+					setalarm(3);  /* set short timer */
 
 				firstitem = 0;
 
@@ -2111,7 +2121,7 @@ text_samp(time_t curtime, int nsecs,
 				move(statline, 0);
 
 				if (interval && !paused && !rawreadflag)
-					alarm(3);  /* set short timer */
+					setalarm(3);  /* set short timer */
 
 				firstitem = 0;
 
@@ -2210,7 +2220,7 @@ text_samp(time_t curtime, int nsecs,
 				move(statline, 0);
 
 				if (interval && !paused && !rawreadflag)
-					alarm(3);  /* set short timer */
+					setalarm(3);  /* set short timer */
 
 				firstitem = 0;
 
@@ -2240,7 +2250,7 @@ text_samp(time_t curtime, int nsecs,
 
 					if (!rawreadflag)
 					{
-						alarm(1);	/* start the clock */
+						setalarm(1);	/* start the clock */
 					}
 					else
 					{
@@ -2530,7 +2540,7 @@ text_samp(time_t curtime, int nsecs,
 					    maxllclines, statline);
 
 				if (interval && !paused && !rawreadflag)
-					alarm(1);  /* set short timer */
+					setalarm(1);  /* set short timer */
 
 				firstitem = 0;
 
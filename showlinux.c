@@ -77,6 +77,8 @@ int   pagbadness = 10;        /* number per second    */
 
 int   almostcrit = 80;        /* percentage           */
 
+static char stagecostline = 0;  /* boolean: show costs of atop itself */
+
 /*
  * tables with all sys_printdefs
  */
@@ -251,6 +253,21 @@ sys_printdef *llcsyspdefs[] = {
 	&syspdef_BLANKBOX,
         0
 };
+sys_printdef *stgsyspdefs[] = {
+	&syspdef_STGCOLL,
+	&syspdef_STGCPU,
+	&syspdef_STGSYSC,
+	&syspdef_STGSYST,
+	&syspdef_STGCGRP,
+	&syspdef_STGPROC,
+	&syspdef_STGACCT,
+	&syspdef_STGDSYS,
+	&syspdef_STGDTSK,
+	&syspdef_STGRAWW,
+	&syspdef_STGOUTP,
+	&syspdef_BLANKBOX,
+        0
+};
 sys_printdef *psisyspdefs[] = {
 	&syspdef_PSICPUSTOT,
 	&syspdef_PSIMEMSTOT,
@@ -540,6 +557,7 @@ sys_printpair swpline[MAXITEMS];
 sys_printpair memnumaline[MAXITEMS];
 sys_printpair cpunumaline[MAXITEMS];
 sys_printpair llcline[MAXITEMS];
+sys_printpair stgline[MAXITEMS];
 sys_printpair pagline[MAXITEMS];
 sys_printpair psiline[MAXITEMS];
 sys_printpair contline[MAXITEMS];
@@ -1055,6 +1073,25 @@ pricumproc(struct sstat *sstat, struct devtstat *devtstat,
 			sstat, &extra);
                 }
 
+                if (stgline[0].f == 0)
+                {
+                    make_sys_prints(stgline, MAXITEMS,
+	                "STGCOLL:9 "
+	                "STGCPU:8 "
+	                "STGSYSC:7 "
+	                "STGSYST:6 "
+	                "STGPROC:6 "
+	                "STGACCT:3 "
+	                "STGDSYS:4 "
+	                "STGDTSK:5 "
+	                "STGCGRP:2 "
+	                "STGRAWW:3 "
+	                "STGOUTP:2 "
+	                "BLANKBOX:0 ",
+			stgsyspdefs, "builtin stgline",
+			sstat, &extra);
+                }
+
                 if (pagline[0].f == 0)
                 {
                     make_sys_prints(pagline, MAXITEMS,
@@ -2398,6 +2435,18 @@ prisyst(struct sstat *sstat, int curline, int nsecs, int avgval,
                 }
         }
 
+        /*
+        ** costs of atop itself per stage of the previous sample
+        */
+        if (stagecostline)
+        {
+		if (screen)
+			move(curline, 0);
+
+		showsysline(stgline, sstat, &extra, "STG", 0);
+		curline++;
+        }
+
         /*
         ** application statistics
         **
@@ -3055,6 +3104,25 @@ do_ownllcline(char *name, char *val)
 					NULL, NULL);
 }
 
+void
+do_ownstagecostline(char *name, char *val)
+{
+        make_sys_prints(stgline, MAXITEMS, val, stgsyspdefs, name,
+					NULL, NULL);
+}
+
+void
+do_stagecostline(char *name, char *val)
+{
+	if (strcmp(val, "enable") == 0)
+		stagecostline = 1;
+	else if (strcmp(val, "disable") == 0)
+		stagecostline = 0;
+	else
+		mcleanstop(1, "atoprc - %s: value 'enable' or 'disable' expected\n",
+								name);
+}
+
 void
 do_owndskline(char *name, char *val)
 {
@@ -150,6 +150,8 @@ void do_ownpagline(char *, char *);
 void do_ownmemnumaline(char *, char *);
 void do_owncpunumaline(char *, char *);
 void do_ownllcline(char *, char *);
+void do_ownstagecostline(char *, char *);
+void do_stagecostline(char *, char *);
 void do_owndskline(char *, char *);
 void do_ownnettransportline(char *, char *);
 void do_ownnetnetline(char *, char *);
@@ -276,6 +278,17 @@ extern sys_printdef syspdef_NUMACPUGUEST;
 extern sys_printdef syspdef_LLCMBMTOTAL;
 extern sys_printdef syspdef_LLCMBMLOCAL;
 extern sys_printdef syspdef_NUMLLC;
+extern sys_printdef syspdef_STGCOLL;
+extern sys_printdef syspdef_STGCPU;
+extern sys_printdef syspdef_STGSYSC;
+extern sys_printdef syspdef_STGSYST;
+extern sys_printdef syspdef_STGCGRP;
+extern sys_printdef syspdef_STGPROC;
+extern sys_printdef syspdef_STGACCT;
+extern sys_printdef syspdef_STGDSYS;
+extern sys_printdef syspdef_STGDTSK;
+extern sys_printdef syspdef_STGRAWW;
+extern sys_printdef syspdef_STGOUTP;
 extern sys_printdef syspdef_PAGSCAN;
 extern sys_printdef syspdef_PAGSTEAL;
 extern sys_printdef syspdef_PAGSTALL;
@@ -51,6 +51,7 @@
 #include "photosyst.h"
 #include "showgeneric.h"
 #include "showlinux.h"
+#include "stagecost.h"
 
 static void	addblanks(double *, double *);
 static void	sumscaling(struct sstat *, count_t *, count_t *, count_t *);
@@ -3502,6 +3503,158 @@ sysprt_NFSRCNOCA(struct sstat *sstat, extraparam *as, int badness, int *color)
 
 sys_printdef syspdef_NFSRCNOCA = {"NFSRCNOCA", sysprt_NFSRCNOCA, NULL};
 /*******************************************************************/
+/*
+** costs of atop itself per stage (wall-clock time)
+*/
+static void
+stgtime2str(count_t usecs, char *buf, int bufsize)
+{
+	if (usecs < 1000)
+		snprintf(buf, bufsize, "%4lldus", usecs);
+	else if (usecs < 100000)
+		snprintf(buf, bufsize, "%4.1fms", usecs / 1000.0);
+	else if (usecs < 10000000)
+		snprintf(buf, bufsize, "%4lldms", usecs / 1000);
+	else
+		snprintf(buf, bufsize, "%5.1fs", usecs / 1000000.0);
+}
+
+static char *
+sysprt_STGCOLL(struct sstat *sstat, extraparam *as, int badness, int *color) 
+{
+        static char	buf[32]="coll  ";
+	count_t		usecs = 0;
+	int		i;
+
+	for (i=STGSYST; i <= STGDTSK; i++)
+		usecs += stagecost.stage[i].wallus;
+
+	stgtime2str(usecs, buf+6, sizeof buf - 6);
+        return buf;
+}
+
+sys_printdef syspdef_STGCOLL = {"STGCOLL", sysprt_STGCOLL, NULL};
+/*******************************************************************/
+static char *
+sysprt_STGCPU(struct sstat *sstat, extraparam *as, int badness, int *color) 
+{
+        static char	buf[32]="cpu   ";
+	count_t		usecs = 0;
+	int		i;
+
+	for (i=0; i < NRSTAGES; i++)
+		usecs += stagecost.stage[i].cpuus;
+
+	stgtime2str(usecs, buf+6, sizeof buf - 6);
+        return buf;
+}
+
+sys_printdef syspdef_STGCPU = {"STGCPU", sysprt_STGCPU, NULL};
+/*******************************************************************/
+static char *
+sysprt_STGSYSC(struct sstat *sstat, extraparam *as, int badness, int *color) 
+{
+        static char	buf[32]="sysc  ";
+	count_t		nsysc = 0;
+	int		i;
+
+	for (i=0; i < NRSTAGES; i++)
+		nsysc += stagecost.stage[i].nsysc;
+
+        val2valstr(nsysc, buf+6, 6, 0, 0);
+        return buf;
+}
+
+sys_printdef syspdef_STGSYSC = {"STGSYSC", sysprt_STGSYSC, NULL};
+/*******************************************************************/
+static char *
+sysprt_STGSYST(struct sstat *sstat, extraparam *as, int badness, int *color) 
+{
+        static char buf[32]="syst  ";
+
+	stgtime2str(stagecost.stage[STGSYST].wallus, buf+6, sizeof buf - 6);
+        return buf;
+}
+
+sys_printdef syspdef_STGSYST = {"STGSYST", sysprt_STGSYST, NULL};
+/*******************************************************************/
+static char *
+sysprt_STGCGRP(struct sstat *sstat, extraparam *as, int badness, int *color) 
+{
+        static char buf[32]="cgrp  ";
+
+	stgtime2str(stagecost.stage[STGCGRP].wallus, buf+6, sizeof buf - 6);
+        return buf;
+}
+
+sys_printdef syspdef_STGCGRP = {"STGCGRP", sysprt_STGCGRP, NULL};
+/*******************************************************************/
+static char *
+sysprt_STGPROC(struct sstat *sstat, extraparam *as, int badness, int *color) 
+{
+        static char buf[32]="proc  ";
+
+	stgtime2str(stagecost.stage[STGPROC].wallus, buf+6, sizeof buf - 6);
+        return buf;
+}
+
+sys_printdef syspdef_STGPROC = {"STGPROC", sysprt_STGPROC, NULL};
+/*******************************************************************/
+static char *
+sysprt_STGACCT(struct sstat *sstat, extraparam *as, int badness, int *color) 
+{
+        static char buf[32]="acct  ";
+
+	stgtime2str(stagecost.stage[STGACCT].wallus, buf+6, sizeof buf - 6);
+        return buf;
+}
+
+sys_printdef syspdef_STGACCT = {"STGACCT", sysprt_STGACCT, NULL};
+/*******************************************************************/
+static char *
+sysprt_STGDSYS(struct sstat *sstat, extraparam *as, int badness, int *color) 
+{
+        static char buf[32]="dsys  ";
+
+	stgtime2str(stagecost.stage[STGDSYS].wallus, buf+6, sizeof buf - 6);
+        return buf;
+}
+
+sys_printdef syspdef_STGDSYS = {"STGDSYS", sysprt_STGDSYS, NULL};
+/*******************************************************************/
+static char *
+sysprt_STGDTSK(struct sstat *sstat, extraparam *as, int badness, int *color) 
+{
+        static char buf[32]="dtsk  ";
+
+	stgtime2str(stagecost.stage[STGDTSK].wallus, buf+6, sizeof buf - 6);
+        return buf;
+}
+
+sys_printdef syspdef_STGDTSK = {"STGDTSK", sysprt_STGDTSK, NULL};
+/*******************************************************************/
+static char *
+sysprt_STGRAWW(struct sstat *sstat, extraparam *as, int badness, int *color) 
+{
+        static char buf[32]="raww  ";
+
+	stgtime2str(stagecost.stage[STGRAWW].wallus, buf+6, sizeof buf - 6);
+        return buf;
+}
+
+sys_printdef syspdef_STGRAWW = {"STGRAWW", sysprt_STGRAWW, NULL};
+/*******************************************************************/
+static char *
+sysprt_STGOUTP(struct sstat *sstat, extraparam *as, int badness, int *color) 
+{
+        static char buf[32]="outp  ";
+
+	stgtime2str(stagecost.stage[STGOUTP].wallus, buf+6, sizeof buf - 6);
+        return buf;
+}
+
+sys_printdef syspdef_STGOUTP = {"STGOUTP", sysprt_STGOUTP, NULL};
+/*******************************************************************/
 static char *
 sysprt_BLANKBOX(struct sstat *sstat, extraparam *notused, int badness, int *color) 
 {
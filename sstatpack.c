@@ -0,0 +1,207 @@
+/*
+** ATOP - System & Process Monitor
+**
+** The program 'atop' offers the possibility to view the activity of
+** the system on system-level as well as process-level.
+**
+** This source-file contains functions to handle the arrays in the
+** struct sstat of which only the first entries are in use (per-cpu,
+** per-disk, per-interface, ...). Only the entries in use are cleared
+** before a new sample is taken and only those entries are stored in
+** the raw file (packed representation).
+**
+** This source-file is also linked into atophide, so it should not
+** depend on other modules of atop.
+** ==========================================================================
+**
+** This program is free software; you can redistribute it and/or modify it
+** under the terms of the GNU General Public License as published by the
+** Free Software Foundation; either version 2, or (at your option) any
+** later version.
+**
+** This program is distributed in the hope that it will be useful, but
+** WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU General Public License for more details.
+*/
+
+#include <sys/types.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "atop.h"
+#include "photosyst.h"
+
+/*
+** description of an array in struct sstat; the number of entries
+** in use is kept in a counter that precedes the array, while the
+** entry behind the last entry in use might act as terminator
+** (empty name) and is therefore considered to be in use as well
+*/
+struct sstatarray {
+	size_t	arroff;		// offset of array in struct sstat
+	size_t	elemsize;	// size of one entry
+	long	maxelem;	// total number of entries
+	size_t	cntoff;		// offset of counter in struct sstat
+	size_t	cntsize;	// size of counter (int or count_t)
+};
+
+#define	SSARRAY(arr, cnt)						\
+	{ offsetof(struct sstat, arr),					\
+	  sizeof ((struct sstat *)0)->arr[0],				\
+	  sizeof ((struct sstat *)0)->arr /				\
+	  sizeof ((struct sstat *)0)->arr[0],				\
+	  offsetof(struct sstat, cnt),					\
+	  sizeof ((struct sstat *)0)->cnt }
+
+/*
+** arrays in order of their offset in struct sstat
+*/
+static struct sstatarray	ssarrays[] = {
+	SSARRAY(cpu.cpu,		cpu.nrcpu),
+	SSARRAY(intf.intf,		intf.nrintf),
+	SSARRAY(memnuma.numa,		memnuma.nrnuma),
+	SSARRAY(cpunuma.numa,		cpunuma.nrnuma),
+	SSARRAY(dsk.dsk,		dsk.ndsk),
+	SSARRAY(dsk.mdd,		dsk.nmdd),
+	SSARRAY(dsk.lvm,		dsk.nlvm),
+	SSARRAY(nfs.nfsmounts.nfsmnt,	nfs.nfsmounts.nrmounts),
+	SSARRAY(cfs.cont,		cfs.nrcontainer),
+	SSARRAY(gpu.gpu,		gpu.nrgpus),
+	SSARRAY(ifb.ifb,		ifb.nrports),
+	SSARRAY(llc.perllc,		llc.nrllcs),
+};
+
+#define	NSSARRAYS	(sizeof ssarrays / sizeof ssarrays[0])
+
+/*
+** determine the number of entries in use for an array
+** (counter value plus terminator entry)
+*/
+static long
+usedentries(struct sstat *sp, struct sstatarray *sa)
+{
+	long	cnt;
+
+	if (sa->cntsize == sizeof(int))
+		cnt = *(int *)((char *)sp + sa->cntoff);
+	else
+		cnt = *(count_t *)((char *)sp + sa->cntoff);
+
+	if (cnt < 0)
+		return 0;
+
+	if (cnt >= sa->maxelem)
+		return sa->maxelem;
+
+	return cnt + 1;
+}
+
+/*
+** clear the struct sstat before it is filled with a new sample;
+** the entries of the arrays that were not in use for the previous
+** contents are expected to be cleared already
+*/
+void
+clearsstat(struct sstat *sp)
+{
+	struct sstatarray	*sa;
+	size_t			pos = 0;
+	long			used[NSSARRAYS];
+
+	/*
+	** determine all numbers of entries in use before clearing,
+	** because several counters might precede one array
+	*/
+	for (sa = ssarrays; sa < &ssarrays[NSSARRAYS]; sa++)
+		used[sa - ssarrays] = usedentries(sp, sa);
+
+	for (sa = ssarrays; sa < &ssarrays[NSSARRAYS]; sa++)
+	{
+		memset((char *)sp + pos, 0,
+			sa->arroff - pos + used[sa - ssarrays] * sa->elemsize);
+
+		pos = sa->arroff + sa->maxelem * sa->elemsize;
+	}
+
+	memset((char *)sp + pos, 0, sizeof(struct sstat) - pos);
+}
+
+/*
+** copy the struct sstat to the buffer in packed representation,
+** i.e. without the array entries that are not in use
+**
+** the buffer should have the size of a struct sstat
+**
+** return value: length of packed representation
+*/
+size_t
+packsstat(struct sstat *sp, char *buf)
+{
+	struct sstatarray	*sa;
+	size_t			pos = 0, len = 0, n;
+
+	for (sa = ssarrays; sa < &ssarrays[NSSARRAYS]; sa++)
+	{
+		n = sa->arroff - pos + usedentries(sp, sa) * sa->elemsize;
+
+		memcpy(buf + len, (char *)sp + pos, n);
+
+		len += n;
+		pos  = sa->arroff + sa->maxelem * sa->elemsize;
+	}
+
+	memcpy(buf + len, (char *)sp + pos, sizeof(struct sstat) - pos);
+
+	return len + sizeof(struct sstat) - pos;
+}
+
+/*
+** rebuild the struct sstat from its packed representation
+** (the array entries that are not in use are cleared)
+**
+** return value: 1 - success
+**               0 - packed representation is corrupt
+*/
+int
+unpacksstat(char *buf, size_t buflen, struct sstat *sp)
+{
+	struct sstatarray	*sa;
+	size_t			pos = 0, len = 0, n;
+	long			used;
+
+	for (sa = ssarrays; sa < &ssarrays[NSSARRAYS]; sa++)
+	{
+		n = sa->arroff - pos;		// part in front of array
+
+		if (len + n > buflen)
+			return 0;
+
+		memcpy((char *)sp + pos, buf + len, n);
+
+		len += n;
+		used = usedentries(sp, sa);	// counter just copied
+		n    = used * sa->elemsize;
+
+		if (len + n > buflen)
+			return 0;
+
+		memcpy((char *)sp + sa->arroff, buf + len, n);
+		memset((char *)sp + sa->arroff + n, 0,
+				(sa->maxelem - used) * sa->elemsize);
+
+		len += n;
+		pos  = sa->arroff + sa->maxelem * sa->elemsize;
+	}
+
+	n = sizeof(struct sstat) - pos;		// part behind last array
+
+	if (len + n != buflen)
+		return 0;
+
+	memcpy((char *)sp + pos, buf + len, n);
+
+	return 1;
+}
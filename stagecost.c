@@ -0,0 +1,181 @@
+/*
+** ATOP - System & Process Monitor
+**
+** The program 'atop' offers the possibility to view the activity of
+** the system on system-level as well as process-level.
+**
+** This source-file contains the functions to measure the costs of atop
+** itself per stage of a sample: the wall-clock time, the cpu time and
+** the number of read/write system calls and bytes (from /proc/self/io).
+**
+** The counters are gathered for the whole process, unless the stage is
+** executed by a separate thread (see 'parallelstages'); in that case
+** the counters of that thread only are used.
+** ==========================================================================
+**
+** This program is free software; you can redistribute it and/or modify it
+** under the terms of the GNU General Public License as published by the
+** Free Software Foundation; either version 2, or (at your option) any
+** later version.
+**
+** This program is distributed in the hope that it will be useful, but
+** WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU General Public License for more details.
+*/
+
+#include <sys/types.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "atop.h"
+#include "stagecost.h"
+
+struct stagecost	stagecost;
+
+const char		*stagenames[NRSTAGES] = {
+	"syst", "cgrp", "proc", "acct", "dsys", "dtsk", "raww", "outp",
+};
+
+static ssize_t	getiocounters(struct stgmark *);
+
+/*
+** clear the costs of the stages before a new sample is gathered,
+** except the costs of the stages that concern the previous sample
+*/
+void
+stgclear(void)
+{
+	int	i;
+
+	for (i=0; i < NRSTAGES; i++)
+	{
+		if (i != STGRAWW && i != STGOUTP)
+			memset(&stagecost.stage[i], 0, sizeof stagecost.stage[i]);
+	}
+}
+
+/*
+** take a snapshot of the counters at the start of a stage
+** (thread: boolean to use the counters of the calling thread only)
+*/
+void
+stgstart(struct stgmark *mp, int thread)
+{
+	ssize_t	len;
+
+	mp->thread = thread;
+
+	clock_gettime(CLOCK_MONOTONIC, &mp->wall);
+	clock_gettime(thread ? CLOCK_THREAD_CPUTIME_ID :
+	                       CLOCK_PROCESS_CPUTIME_ID, &mp->cpu);
+
+	/*
+	** the read of the counters themselves is only reflected by
+	** the next snapshot, so it should not be accounted to the stage
+	*/
+	if ( (len = getiocounters(mp)) > 0)
+	{
+		mp->nsysc  += 1;
+		mp->nbytes += len;
+	}
+}
+
+/*
+** take a snapshot of the counters at the end of a stage and
+** store the differences with the start as costs of the stage
+*/
+void
+stgstop(struct stgmark *mp, int stage)
+{
+	struct stgmark	end;
+	struct stgcost	*sc = &stagecost.stage[stage];
+
+	clock_gettime(CLOCK_MONOTONIC, &end.wall);
+	clock_gettime(mp->thread ? CLOCK_THREAD_CPUTIME_ID :
+	                           CLOCK_PROCESS_CPUTIME_ID, &end.cpu);
+
+	end.thread = mp->thread;
+
+	getiocounters(&end);
+
+	sc->wallus = (end.wall.tv_sec  - mp->wall.tv_sec)  * 1000000LL +
+	             (end.wall.tv_nsec - mp->wall.tv_nsec) / 1000;
+	sc->cpuus  = (end.cpu.tv_sec   - mp->cpu.tv_sec)   * 1000000LL +
+	             (end.cpu.tv_nsec  - mp->cpu.tv_nsec)  / 1000;
+	sc->nsysc  = end.nsysc  - mp->nsysc;
+	sc->nbytes = end.nbytes - mp->nbytes;
+}
+
+/*
+** obtain the number of read/write system calls and the number of
+** bytes read/written by this process or this thread
+**
+** return value: number of bytes read from the counters file
+**
+** the file of the process is kept open, while the file of a thread
+** is opened every time (such thread only lives for one sample)
+*/
+static ssize_t
+getiocounters(struct stgmark *mp)
+{
+	static int	procfd = -1;
+	char		buf[512], *p;
+	count_t		rchar = 0, wchar = 0, syscr = 0, syscw = 0;
+	ssize_t		len;
+	int		fd;
+
+	mp->nsysc  = 0;
+	mp->nbytes = 0;
+
+	if (mp->thread)
+	{
+		if ( (fd = open("/proc/thread-self/io", O_RDONLY)) == -1)
+			return 0;
+	}
+	else
+	{
+		if (procfd == -1)
+		{
+			if ( (procfd = open("/proc/self/io",
+					O_RDONLY|O_CLOEXEC)) == -1)
+				return 0;
+		}
+
+		fd = procfd;
+	}
+
+	len = pread(fd, buf, sizeof buf - 1, 0);
+
+	if (mp->thread)
+		close(fd);
+
+	if (len <= 0)
+		return 0;
+
+	buf[len] = '\0';
+
+	for (p = buf; p && *p; p = strchr(p, '\n'))
+	{
+		if (*p == '\n')
+			p++;
+
+		if (strncmp(p, "rchar:", 6) == 0)
+			rchar = strtoll(p+6, NULL, 10);
+		else if (strncmp(p, "wchar:", 6) == 0)
+			wchar = strtoll(p+6, NULL, 10);
+		else if (strncmp(p, "syscr:", 6) == 0)
+			syscr = strtoll(p+6, NULL, 10);
+		else if (strncmp(p, "syscw:", 6) == 0)
+			syscw = strtoll(p+6, NULL, 10);
+	}
+
+	mp->nsysc  = syscr + syscw;
+	mp->nbytes = rchar + wchar;
+
+	return len;
+}
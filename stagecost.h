@@ -0,0 +1,69 @@
+/*
+** ATOP - System & Process Monitor
+**
+** The program 'atop' offers the possibility to view the activity of
+** the system on system-level as well as process-level.
+**
+** Include-file describing the costs of atop itself per stage of
+** gathering, calculating and writing a sample.
+** ==========================================================================
+**
+** This program is free software; you can redistribute it and/or modify it
+** under the terms of the GNU General Public License as published by the
+** Free Software Foundation; either version 2, or (at your option) any
+** later version.
+**
+** This program is distributed in the hope that it will be useful, but
+** WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU General Public License for more details.
+*/
+
+#ifndef __STAGECOST__
+#define __STAGECOST__
+
+/*
+** stages of which the costs are measured
+** (the costs of the stages marked with * concern the previous sample,
+** because they are measured while the current sample is written)
+*/
+#define	STGSYST		0	/* system-level counters		*/
+#define	STGCGRP		1	/* cgroup-level counters		*/
+#define	STGPROC		2	/* process-level counters		*/
+#define	STGACCT		3	/* exited processes (accounting)	*/
+#define	STGDSYS		4	/* system-level deviations		*/
+#define	STGDTSK		5	/* process-level deviations		*/
+#define	STGRAWW		6	/* compress and write raw record (*)	*/
+#define	STGOUTP		7	/* all output (*)			*/
+#define	NRSTAGES	8
+
+struct stgcost {
+	count_t	wallus;		/* wall-clock time in microseconds	*/
+	count_t	cpuus;		/* cpu time in microseconds		*/
+	count_t	nsysc;		/* number of read/write system calls	*/
+	count_t	nbytes;		/* number of bytes read/written		*/
+};
+
+struct stagecost {
+	struct stgcost	stage[NRSTAGES];
+};
+
+/*
+** snapshot taken at the start of a stage
+*/
+struct stgmark {
+	struct timespec	wall;
+	struct timespec	cpu;
+	count_t		nsysc;
+	count_t		nbytes;
+	char		thread;		/* boolean: counters of thread only */
+};
+
+extern struct stagecost	stagecost;
+extern const char	*stagenames[];
+
+void	stgclear(void);
+void	stgstart(struct stgmark *, int);
+void	stgstop(struct stgmark *, int);
+
+#endif
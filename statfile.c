@@ -0,0 +1,336 @@
+/*
+** ATOP - System & Process Monitor
+**
+** The program 'atop' offers the possibility to view the activity of
+** the system on system-level as well as process-level.
+**
+** This source-file contains the registry of statistics files below
+** /proc and /sys that are read during every sample. Such a file is only
+** opened once and is reread with pread() from offset 0 into a buffer
+** that is reused; the contents are offered to the caller as a stdio
+** stream, so the existing parsers (fgets, fscanf, ...) can be used.
+**
+** A file that does not exist any more (e.g. of a CPU that went offline
+** or a device that has been removed) is removed from the registry.
+**
+** The files below /proc and /sys can be taken from an alternate root
+** directory instead (e.g. a synthetic tree for benchmarking purposes).
+** ==========================================================================
+**
+** This program is free software; you can redistribute it and/or modify it
+** under the terms of the GNU General Public License as published by the
+** Free Software Foundation; either version 2, or (at your option) any
+** later version.
+**
+** This program is distributed in the hope that it will be useful, but
+** WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU General Public License for more details.
+*/
+
+#define _GNU_SOURCE
+#include <sys/types.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+
+#include "atop.h"
+#include "statfile.h"
+
+#define	NSFHASH		256		/* MUST be a power of 2 !!!	*/
+#define	MAXSTATFILES	1024		/* maximum registered files	*/
+#define	SFBUFINIT	4096		/* initial size of buffer	*/
+
+struct statfile {
+	struct statfile	*next;		/* next in hash chain		*/
+	char		*path;		/* absolute path name		*/
+	int		fd;		/* open descriptor or -1	*/
+	char		*buf;		/* buffer with contents		*/
+	size_t		bufsize;	/* size of buffer		*/
+};
+
+static struct statfile	*sfhash[NSFHASH];
+static int		nstatfiles;
+static pthread_mutex_t	sfmutex = PTHREAD_MUTEX_INITIALIZER;
+
+static char		sfrootdir[512];	/* alternate root or empty	*/
+
+static unsigned int	sfhashval(const char *);
+static struct statfile	*sfsearch(const char *);
+static void		sfevict(struct statfile *);
+static ssize_t		sfread(struct statfile *);
+
+/*
+** open the statistics file with the given absolute path name
+** and return its current contents as a stdio stream that has
+** to be closed with fclose() by the caller
+**
+** when the maximum number of registered files is reached,
+** the file is opened in the conventional way
+**
+** return value: stream or NULL (file can not be read)
+*/
+FILE *
+sfopen(const char *path)
+{
+	struct statfile	*sf;
+	ssize_t		len;
+	char		rootpath[1024];
+
+	path = sfpath(path, rootpath, sizeof rootpath);
+
+	if ( (sf = sfsearch(path)) == NULL)
+		return fopen(path, "r");
+
+	if ( (len = sfread(sf)) == -1)
+	{
+		sfevict(sf);
+		return NULL;
+	}
+
+	/*
+	** a stream of zero bytes can not be created, so
+	** an empty file is offered as a null-byte only
+	*/
+	if (len == 0)
+	{
+		sf->buf[0] = '\0';
+		len = 1;
+	}
+
+	return fmemopen(sf->buf, len, "r");
+}
+
+/*
+** obtain the contents of the statistics file with the given absolute
+** path name as one decimal value (e.g. a counter in sysfs), without
+** creating a stdio stream
+**
+** return value: 1 (success) or 0 (file can not be read or no value)
+*/
+int
+sfgetval(const char *path, long long *valp)
+{
+	struct statfile	*sf;
+	ssize_t		len;
+	char		*endp, rootpath[1024];
+	FILE		*fp;
+
+	path = sfpath(path, rootpath, sizeof rootpath);
+
+	if ( (sf = sfsearch(path)) == NULL)
+	{
+		int	ok = 0;
+
+		if ( (fp = fopen(path, "r")) )
+		{
+			ok = fscanf(fp, "%lld", valp) == 1;
+			fclose(fp);
+		}
+
+		return ok;
+	}
+
+	if ( (len = sfread(sf)) <= 0)
+	{
+		if (len == -1)
+			sfevict(sf);
+		return 0;
+	}
+
+	sf->buf[len] = '\0';	// length always less than buffer size
+
+	*valp = strtoll(sf->buf, &endp, 10);
+
+	return endp != sf->buf;
+}
+
+/*
+** define an alternate root directory for the files below /proc
+** and /sys (NULL or empty string: the real filesystems)
+*/
+void
+sfsetroot(const char *rootdir)
+{
+	if (rootdir)
+		safe_strcpy(sfrootdir, rootdir, sizeof sfrootdir);
+	else
+		sfrootdir[0] = '\0';
+}
+
+/*
+** translate the absolute path name of a file below /proc or /sys
+** to the path name below the alternate root directory (if defined)
+**
+** return value: translated path name in the given buffer or
+**               the original path name (no alternate root)
+*/
+const char *
+sfpath(const char *path, char *buf, size_t bufsize)
+{
+	if (sfrootdir[0] == '\0')
+		return path;
+
+	snprintf(buf, bufsize, "%s%s", sfrootdir, path);
+
+	return buf;
+}
+
+/*
+** determine the hash chain of a path name
+*/
+static unsigned int
+sfhashval(const char *path)
+{
+	unsigned int	hash = 0;
+	const char	*p;
+
+	for (p=path; *p; p++)
+		hash = hash * 31 + *p;
+
+	return hash & (NSFHASH-1);
+}
+
+/*
+** search the registry entry of a file and
+** create a new entry when not found yet
+*/
+static struct statfile *
+sfsearch(const char *path)
+{
+	struct statfile	*sf;
+	unsigned int	hash = sfhashval(path);
+
+	pthread_mutex_lock(&sfmutex);
+
+	for (sf = sfhash[hash]; sf; sf = sf->next)
+	{
+		if (strcmp(sf->path, path) == 0)
+			break;
+	}
+
+	if (!sf && nstatfiles < MAXSTATFILES)
+	{
+		sf = calloc(1, sizeof *sf);
+		ptrverify(sf, "Malloc failed for statfile struct\n");
+
+		sf->path = strdup(path);
+		ptrverify(sf->path, "Malloc failed for statfile path\n");
+
+		sf->fd      = -1;
+		sf->bufsize = SFBUFINIT;
+		sf->buf     = malloc(sf->bufsize);
+		ptrverify(sf->buf, "Malloc failed for statfile buffer\n");
+
+		sf->next     = sfhash[hash];
+		sfhash[hash] = sf;
+
+		nstatfiles++;
+	}
+
+	pthread_mutex_unlock(&sfmutex);
+
+	return sf;
+}
+
+/*
+** remove the registry entry of a file that can not be read because
+** it does not exist (any more), so its slot can be reused
+*/
+static void
+sfevict(struct statfile *sf)
+{
+	struct statfile	**sfp;
+
+	if (errno != ENOENT && errno != ENODEV)
+		return;
+
+	pthread_mutex_lock(&sfmutex);
+
+	for (sfp = &sfhash[sfhashval(sf->path)]; *sfp; sfp = &(*sfp)->next)
+	{
+		if (*sfp == sf)
+		{
+			*sfp = sf->next;
+			nstatfiles--;
+			break;
+		}
+	}
+
+	pthread_mutex_unlock(&sfmutex);
+
+	if (sf->fd != -1)
+		close(sf->fd);
+
+	free(sf->buf);
+	free(sf->path);
+	free(sf);
+}
+
+/*
+** read the complete contents of a registered file into its buffer
+** (the buffer is enlarged when needed); the file is (re)opened
+** when it has not been opened yet or when the open descriptor
+** became stale (e.g. sysfs entry that has been recreated)
+**
+** a file in procfs (seq_file) only delivers about one page per read,
+** so the file is read at increasing offsets until end-of-file
+**
+** return value: number of bytes read or -1 (failure)
+**               (always less than the buffer size)
+*/
+static ssize_t
+sfread(struct statfile *sf)
+{
+	ssize_t	len;
+	size_t	total = 0;
+	int	reopened = 0;
+
+	while (1)
+	{
+		if (sf->fd == -1)
+		{
+			if ( (sf->fd = open(sf->path, O_RDONLY|O_CLOEXEC)) == -1)
+				return -1;
+
+			reopened = 1;
+		}
+
+		/*
+		** buffer full: enlarge and continue reading
+		** (one byte is kept free for a null-byte of the caller)
+		*/
+		if (total == sf->bufsize - 1)
+		{
+			sf->bufsize *= 2;
+			sf->buf      = realloc(sf->buf, sf->bufsize);
+
+			ptrverify(sf->buf, "Malloc failed for statfile buffer\n");
+		}
+
+		len = pread(sf->fd, sf->buf+total, sf->bufsize-total-1, total);
+
+		if (len == -1)
+		{
+			close(sf->fd);
+			sf->fd = -1;
+
+			if (total || reopened || (errno != ESTALE &&
+			                 errno != ENOENT && errno != ENODEV))
+				return -1;
+
+			continue;	// reopen once
+		}
+
+		if (len == 0)		// end-of-file
+			break;
+
+		total += len;
+	}
+
+	return total;
+}
@@ -0,0 +1,31 @@
+/*
+** ATOP - System & Process Monitor
+**
+** The program 'atop' offers the possibility to view the activity of
+** the system on system-level as well as process-level.
+**
+** Include-file describing the registry of statistics files below
+** /proc and /sys that are kept open and reread during every sample,
+** possibly below an alternate root directory.
+** ==========================================================================
+**
+** This program is free software; you can redistribute it and/or modify it
+** under the terms of the GNU General Public License as published by the
+** Free Software Foundation; either version 2, or (at your option) any
+** later version.
+**
+** This program is distributed in the hope that it will be useful, but
+** WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU General Public License for more details.
+*/
+
+#ifndef __STATFILE__
+#define __STATFILE__
+
+FILE		*sfopen(const char *);
+int		sfgetval(const char *, long long *);
+void		sfsetroot(const char *);
+const char	*sfpath(const char *, char *, size_t);
+
+#endif
@@ -0,0 +1,311 @@
+/*
+** ATOP - System & Process Monitor
+**
+** The program 'atop' offers the possibility to view the activity of
+** the system on system-level as well as process-level.
+**
+** This source-file contains functions to obtain the counters of
+** individual threads via the TASKSTATS interface of the kernel
+** (generic netlink) in binary form, as an alternative for parsing
+** the files io and schedstat below /proc/pid/task/tid.
+** ==========================================================================
+**
+** This program is free software; you can redistribute it and/or modify it
+** under the terms of the GNU General Public License as published by the
+** Free Software Foundation; either version 2, or (at your option) any
+** later version.
+**
+** This program is distributed in the hope that it will be useful, but
+** WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU General Public License for more details.
+*/
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include <linux/netlink.h>
+#include <linux/genetlink.h>
+#include <linux/taskstats.h>
+
+#include "atop.h"
+#include "photoproc.h"
+
+/*
+** generic macro's
+*/
+#define GENLMSG_DATA(glh)	((void *)((char *)NLMSG_DATA(glh) + GENL_HDRLEN))
+#define GENLMSG_PAYLOAD(glh)	(NLMSG_PAYLOAD(glh, 0)    - GENL_HDRLEN)
+#define NLA_DATA(na)		((void *)((char*)(na)     + NLA_HDRLEN))
+#define NLA_PAYLOAD(len)	(len                      - NLA_HDRLEN)
+
+/*
+** message format to communicate with NETLINK
+*/
+struct msgtemplate {
+	struct nlmsghdr		n;
+	struct genlmsghdr	g;
+	char			buf[1024];
+};
+
+static int	tsopen(void);
+static int	tssend(int, __u16, __u8, __u16, void *, int);
+static int	tsrecv(int, struct msgtemplate *);
+
+/*
+** family id of TASKSTATS (0 when not available)
+** and the netlink socket of the calling thread (every
+** thread gathering task counters uses its own socket)
+*/
+static __u16		famid;
+static __thread int	tssock = -1;
+
+/*
+** verify if the TASKSTATS interface can be used, i.e. the family
+** is registered and atop is allowed to issue TASKSTATS_CMD_GET
+** (requires root privileges)
+**
+** return value:
+**	1 - TASKSTATS usable
+**	0 - not usable (counters have to be obtained via /proc)
+*/
+int
+taskstats_probe(void)
+{
+	struct msgtemplate	msg;
+	struct nlattr		*na;
+	struct tstat		tmp;
+
+	regainrootprivs();
+
+	if ( (tssock = tsopen()) == -1)
+		goto drop_and_fail;
+
+	/*
+	** get the family id for the TASKSTATS family
+	*/
+	if (tssend(tssock, GENL_ID_CTRL, CTRL_CMD_GETFAMILY,
+		CTRL_ATTR_FAMILY_NAME,
+		TASKSTATS_GENL_NAME, sizeof TASKSTATS_GENL_NAME) == -1)
+		goto close_and_fail;
+
+	if (tsrecv(tssock, &msg) == -1)
+		goto close_and_fail;
+
+	na = (struct nlattr *) GENLMSG_DATA(&msg);
+	na = (struct nlattr *) ((char *) na + NLA_ALIGN(na->nla_len));
+
+	if (na->nla_type != CTRL_ATTR_FAMILY_ID)
+		goto close_and_fail;
+
+	famid = *(__u16 *) NLA_DATA(na);
+
+	/*
+	** try to obtain the counters of atop itself
+	*/
+	if (! taskstats_gettask(getpid(), &tmp))
+	{
+		famid = 0;
+		goto close_and_fail;
+	}
+
+	if (! droprootprivs())
+		mcleanstop(42, "failed to drop root privs\n");
+
+	return 1;
+
+    close_and_fail:
+	close(tssock);
+	tssock = -1;
+
+    drop_and_fail:
+	if (! droprootprivs())
+		mcleanstop(42, "failed to drop root privs\n");
+
+	return 0;
+}
+
+/*
+** obtain the counters of one thread via TASKSTATS and store the
+** run delay, the context switches and (if supported) the disk
+** transfer counters in the tstat struct
+**
+** might be called in parallel by the worker threads; the caller
+** has to regain the root privileges (needed for every request)
+**
+** return value:
+**	1 - counters stored
+**	0 - failed (thread vanished or TASKSTATS not usable)
+*/
+int
+taskstats_gettask(int tid, struct tstat *curthr)
+{
+	struct msgtemplate	msg;
+	struct nlattr		*na, *nested;
+	struct taskstats	ts;
+	int			len, nestlen, success = 0;
+	__u32			pid = tid;
+
+	if (!famid)
+		return 0;
+
+	if (tssock == -1 && (tssock = tsopen()) == -1)
+		return 0;
+
+	if (tssend(tssock, famid, TASKSTATS_CMD_GET,
+			TASKSTATS_CMD_ATTR_PID, &pid, sizeof pid) == -1)
+		return 0;
+
+	if (tsrecv(tssock, &msg) == -1)
+		return 0;
+
+	/*
+	** the reply contains a nested attribute with the pid
+	** and the taskstats struct
+	*/
+	len = GENLMSG_PAYLOAD(&msg.n);
+	na  = (struct nlattr *) GENLMSG_DATA(&msg);
+
+	while (len > 0)
+	{
+		if (na->nla_type == TASKSTATS_TYPE_AGGR_PID)
+		{
+			nestlen = NLA_PAYLOAD(na->nla_len);
+			nested  = (struct nlattr *) NLA_DATA(na);
+
+			while (nestlen > 0)
+			{
+				if (nested->nla_type == TASKSTATS_TYPE_STATS)
+				{
+					int n = NLA_PAYLOAD(nested->nla_len);
+
+					/*
+					** older kernels deliver a smaller
+					** struct than defined here
+					*/
+					memset(&ts, 0, sizeof ts);
+					memcpy(&ts, NLA_DATA(nested),
+					      n < sizeof ts ? n : sizeof ts);
+
+					success = 1;
+					break;
+				}
+
+				nestlen -= NLA_ALIGN(nested->nla_len);
+				nested   = (struct nlattr *) ((char *) nested +
+						NLA_ALIGN(nested->nla_len));
+			}
+
+			break;
+		}
+
+		len -= NLA_ALIGN(na->nla_len);
+		na   = (struct nlattr *) ((char *) na + NLA_ALIGN(na->nla_len));
+	}
+
+	if (success)
+	{
+		curthr->cpu.rundelay	= ts.cpu_delay_total;	// nanoseconds
+		curthr->cpu.nvcsw	= ts.nvcsw;
+		curthr->cpu.nivcsw	= ts.nivcsw;
+
+		if (supportflags & IOSTAT)
+		{
+			curthr->dsk.rsz	 = ts.read_bytes  / 512; // sectors
+			curthr->dsk.rio	 = curthr->dsk.rsz;	 // to enable sort
+			curthr->dsk.wsz	 = ts.write_bytes / 512; // sectors
+			curthr->dsk.wio	 = curthr->dsk.wsz;	 // to enable sort
+			curthr->dsk.cwsz = ts.cancelled_write_bytes / 512;
+		}
+	}
+
+	return success;
+}
+
+/*
+** open a generic netlink socket (the port id is assigned
+** by the kernel, so every thread can open its own socket)
+*/
+static int
+tsopen(void)
+{
+	int			sock;
+	struct sockaddr_nl	nlsockaddr;
+
+	if ( (sock = socket(AF_NETLINK, SOCK_RAW|SOCK_CLOEXEC,
+						NETLINK_GENERIC)) == -1)
+		return -1;
+
+	memset(&nlsockaddr, 0, sizeof nlsockaddr);
+	nlsockaddr.nl_family = AF_NETLINK;
+
+	if (bind(sock, (struct sockaddr *) &nlsockaddr, sizeof nlsockaddr)
+									== -1)
+	{
+		close(sock);
+		return -1;
+	}
+
+	return sock;
+}
+
+/*
+** send a generic netlink command with one attribute
+*/
+static int
+tssend(int sock, __u16 nlmsg_type, __u8 genl_cmd,
+	__u16 nla_type, void *nla_data, int nla_len)
+{
+	struct nlattr		*na;
+	struct sockaddr_nl	nlsockaddr;
+	struct msgtemplate	msg;
+
+	memset(&msg, 0, sizeof(struct nlmsghdr) + sizeof(struct genlmsghdr));
+
+	msg.n.nlmsg_len 	= NLMSG_LENGTH(GENL_HDRLEN);
+	msg.n.nlmsg_type 	= nlmsg_type;
+	msg.n.nlmsg_flags 	= NLM_F_REQUEST;
+	msg.g.cmd 		= genl_cmd;
+	msg.g.version 		= 0x1;
+	na 			= (struct nlattr *) GENLMSG_DATA(&msg);
+	na->nla_type 		= nla_type;
+	na->nla_len 		= nla_len + NLA_HDRLEN;
+
+	memcpy(NLA_DATA(na), nla_data, nla_len);
+	msg.n.nlmsg_len 	+= NLMSG_ALIGN(na->nla_len);
+
+	memset(&nlsockaddr, 0, sizeof(nlsockaddr));
+	nlsockaddr.nl_family = AF_NETLINK;
+
+	if (sendto(sock, &msg, msg.n.nlmsg_len, 0,
+		(struct sockaddr *) &nlsockaddr, sizeof(nlsockaddr))
+						!= msg.n.nlmsg_len)
+		return -1;
+
+	return 0;
+}
+
+/*
+** receive the answer on a command
+*/
+static int
+tsrecv(int sock, struct msgtemplate *msgp)
+{
+	int	len;
+
+	while ( (len = recv(sock, msgp, sizeof *msgp, 0)) == -1)
+	{
+		if (errno != EINTR)
+			return -1;
+	}
+
+	if (msgp->n.nlmsg_type == NLMSG_ERROR || !NLMSG_OK(&msgp->n, len))
+		return -1;
+
+	return len;
+}
@@ -0,0 +1,582 @@
+/*
+** ATOP - System & Process Monitor
+**
+** Test of the parsers of the files stat, status, io and schedstat of a
+** process or thread (procparse.c): for every sample the resulting tstat
+** should be identical to the tstat obtained by the former parsers based
+** on stdio and sscanf(), that are included below as reference.
+**
+** The samples are taken from the captured files in the directory
+** tests/procsamples (or the directory passed as argument) and from
+** the processes and threads that are currently running.
+**
+** Finally the parsing time per file is measured for both the former
+** and the new parsers with the captured samples (already in memory,
+** so without the costs of the system calls).
+** ==========================================================================
+**
+** This program is free software; you can redistribute it and/or modify it
+** under the terms of the GNU General Public License as published by the
+** Free Software Foundation; either version 2, or (at your option) any
+** later version.
+**
+** This program is distributed in the hope that it will be useful, but
+** WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU General Public License for more details.
+*/
+
+#define _GNU_SOURCE
+#include <sys/types.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <time.h>
+
+#include "atop.h"
+#include "photoproc.h"
+#include "procparse.h"
+
+/*
+** globals of atop.c that are used by procparse.c
+*/
+unsigned short	hertz    = 100;
+unsigned int	pagesize = 4096;
+
+#define	BOOTEPOCH	1700000000ULL
+
+static int	nsamples, nfailed;
+
+/*
+** captured samples in memory for the timing of the parsers
+*/
+#define	NBENCHLOOPS	2000
+#define	MAXBENCH	32
+
+static const char	*benchfiles[] = {"stat", "status", "io", "schedstat"};
+
+#define	NBENCHFILES	(sizeof benchfiles / sizeof benchfiles[0])
+
+static struct benchsample {
+	char	isproc;
+	ssize_t	len[NBENCHFILES];
+	char	buf[NBENCHFILES][4096];
+} benchsamps[MAXBENCH];
+
+static int	nbench;
+
+/*
+** reference parsers (taken from the former photoproc.c, only
+** modified to read from the stream passed by the caller)
+*/
+#define	SCANSTAT 	"%c   %d   %*d  %*d  %*d %*d  "	\
+			"%*d  %lld %*d  %lld %*d %lld "	\
+			"%lld %*d  %*d  %d   %d  %*d  "	\
+			"%*d  %ld  %lld %lld %*d %*d  "	\
+			"%*d  %*d  %*d  %*d  %*d %*d  " \
+			"%*d  %*d  %*d  %*d  %*d %*d  "	\
+			"%d   %d   %d   %lld"
+
+static int
+refstat(struct tstat *curtask, FILE *fp, unsigned long long bootepoch,
+								char isproc)
+{
+	int	nr;
+	char	line[4096], *p, *cmdhead, *cmdtail;
+
+	if ( (nr = fread(line, 1, sizeof line-1, fp)) == 0)
+		return 0;
+
+	line[nr] = '\0';	// terminate string
+
+	cmdhead = strchr (line, '(');
+	cmdtail = strrchr(line, ')');
+
+	if (!cmdhead || !cmdtail || cmdtail < cmdhead) // parsing failed?
+		return 0;
+
+	if ( (nr = cmdtail-cmdhead-1) > PNAMLEN)
+		nr = PNAMLEN;
+
+	p = curtask->gen.name;
+
+	memcpy(p, cmdhead+1, nr);
+	*(p+nr) = 0;
+
+	while ( (p = strchr(p, '\n')) != NULL)
+	{
+		*p = '?';
+		p++;
+	}
+
+	curtask->gen.isproc  = isproc;
+	curtask->cpu.rtprio  = 0;
+	curtask->cpu.policy  = 0;
+	curtask->gen.excode  = 0;
+
+	sscanf(line, "%d", &(curtask->gen.pid));  /* fetch pid */
+
+	nr = sscanf(cmdtail+2, SCANSTAT,
+		&(curtask->gen.state), 	&(curtask->gen.ppid),
+		&(curtask->mem.minflt),	&(curtask->mem.majflt),
+		&(curtask->cpu.utime),	&(curtask->cpu.stime),
+		&(curtask->cpu.prio),	&(curtask->cpu.nice),
+		&(curtask->gen.btime),
+		&(curtask->mem.vmem),	&(curtask->mem.rmem),
+		&(curtask->cpu.curcpu),	&(curtask->cpu.rtprio),
+		&(curtask->cpu.policy), &(curtask->cpu.blkdelay));
+
+	if (nr < 12)		/* parsing failed? */
+		return 0;
+
+	curtask->gen.btime   = (curtask->gen.btime+bootepoch)/hertz;
+	curtask->cpu.prio   += 100; 	/* was subtracted by kernel */
+	curtask->mem.vmem   /= 1024;
+	curtask->mem.rmem   *= pagesize/1024;
+
+	switch (curtask->gen.state)
+	{
+  	   case 'R':
+		curtask->gen.nthrrun  = 1;
+		break;
+  	   case 'S':
+		curtask->gen.nthrslpi = 1;
+		break;
+  	   case 'D':
+		curtask->gen.nthrslpu = 1;
+		break;
+	   case 'I':
+		curtask->gen.nthridle = 1;
+		break;
+	}
+
+	return 1;
+}
+
+static void
+refstatus(struct tstat *curtask, FILE *fp)
+{
+	char	line[4096];
+
+	curtask->gen.nthr     = 1;	/* for compat with 2.4 */
+	curtask->cpu.sleepavg = 0;	/* for compat with 2.4 */
+	curtask->mem.vgrow    = 0;	/* calculated later */
+	curtask->mem.rgrow    = 0;	/* calculated later */
+
+	while (fgets(line, sizeof line, fp))
+	{
+		if (memcmp(line, "Tgid:", 5) ==0)
+			sscanf(line, "Tgid: %d", &(curtask->gen.tgid));
+		else if (memcmp(line, "Pid:", 4) ==0)
+			sscanf(line, "Pid: %d", &(curtask->gen.pid));
+		else if (memcmp(line, "SleepAVG:", 9)==0)
+			sscanf(line, "SleepAVG: %d%%", &(curtask->cpu.sleepavg));
+		else if (memcmp(line, "Uid:", 4)==0)
+			sscanf(line, "Uid: %d %d %d %d",
+				&(curtask->gen.ruid), &(curtask->gen.euid),
+				&(curtask->gen.suid), &(curtask->gen.fsuid));
+		else if (memcmp(line, "Gid:", 4)==0)
+			sscanf(line, "Gid: %d %d %d %d",
+				&(curtask->gen.rgid), &(curtask->gen.egid),
+				&(curtask->gen.sgid), &(curtask->gen.fsgid));
+		else if (memcmp(line, "envID:", 6) ==0)
+			sscanf(line, "envID: %d", &(curtask->gen.ctid));
+		else if (memcmp(line, "VPid:", 5) ==0)
+			sscanf(line, "VPid: %d", &(curtask->gen.vpid));
+		else if (memcmp(line, "Threads:", 8)==0)
+			sscanf(line, "Threads: %d", &(curtask->gen.nthr));
+		else if (memcmp(line, "VmData:", 7)==0)
+			sscanf(line, "VmData: %lld", &(curtask->mem.vdata));
+		else if (memcmp(line, "VmStk:", 6)==0)
+			sscanf(line, "VmStk: %lld", &(curtask->mem.vstack));
+		else if (memcmp(line, "VmExe:", 6)==0)
+			sscanf(line, "VmExe: %lld", &(curtask->mem.vexec));
+		else if (memcmp(line, "VmLib:", 6)==0)
+			sscanf(line, "VmLib: %lld", &(curtask->mem.vlibs));
+		else if (memcmp(line, "VmSwap:", 7)==0)
+			sscanf(line, "VmSwap: %lld", &(curtask->mem.vswap));
+		else if (memcmp(line, "VmLck:", 6)==0)
+			sscanf(line, "VmLck: %lld", &(curtask->mem.vlock));
+		else if (memcmp(line, "voluntary_ctxt_switches:", 24)==0)
+			sscanf(line, "voluntary_ctxt_switches: %lld",
+						&(curtask->cpu.nvcsw));
+		else if (memcmp(line, "nonvoluntary_ctxt_switches:", 27)==0)
+			sscanf(line, "nonvoluntary_ctxt_switches: %lld",
+						&(curtask->cpu.nivcsw));
+	}
+}
+
+static void
+refio(struct tstat *curtask, FILE *fp)
+{
+	char	line[4096];
+	count_t	dskrsz=0, dskwsz=0, dskcwsz=0;
+
+	while (fgets(line, sizeof line, fp))
+	{
+		if (memcmp(line, "read_bytes:", 11) == 0)
+		{
+			sscanf(line, "%*s %llu", &dskrsz);
+			dskrsz /= 512;		// in sectors
+		}
+		else if (memcmp(line, "write_bytes:", 12) == 0)
+		{
+			sscanf(line, "%*s %llu", &dskwsz);
+			dskwsz /= 512;		// in sectors
+		}
+		else if (memcmp(line, "cancelled_write_bytes:", 22) == 0)
+		{
+			sscanf(line, "%*s %llu", &dskcwsz);
+			dskcwsz /= 512;		// in sectors
+		}
+	}
+
+	curtask->dsk.rsz	= dskrsz;
+	curtask->dsk.rio	= dskrsz;  // to enable sort
+	curtask->dsk.wsz	= dskwsz;
+	curtask->dsk.wio	= dskwsz;  // to enable sort
+	curtask->dsk.cwsz	= dskcwsz;
+}
+
+static void
+refschedstat(struct tstat *curtask, FILE *fp)
+{
+	char		line[4096];
+	count_t		runtime, rundelay = 0;
+	unsigned long	pcount;
+
+	curtask->cpu.rundelay = 0;
+
+	if (fgets(line, sizeof line, fp))
+	{
+		sscanf(line, "%llu %llu %lu\n", &runtime, &rundelay, &pcount);
+		curtask->cpu.rundelay = rundelay;
+	}
+}
+
+/*
+** read the contents of a file into a buffer that is
+** terminated by a null-byte
+**
+** returns: number of bytes read or -1 when the file can not be read
+*/
+static ssize_t
+readfile(int dirfd, const char *name, char *buf, size_t bufsize)
+{
+	ssize_t	nr, total = 0;
+	int	fd;
+
+	if ( (fd = openat(dirfd, name, O_RDONLY)) == -1)
+		return -1;
+
+	while ( (nr = read(fd, buf+total, bufsize-1-total)) > 0)
+		total += nr;
+
+	close(fd);
+
+	if (nr == -1)
+		return -1;
+
+	buf[total] = '\0';
+
+	return total;
+}
+
+/*
+** parse the files of one task with both parsers and compare the result
+*/
+static void
+testtask(int dirfd, const char *label, char isproc)
+{
+	struct tstat	new, ref;
+	char		buf[4096];
+	ssize_t		len;
+	FILE		*fp;
+	int		newrv, refrv;
+
+	memset(&new, 0, sizeof new);
+	memset(&ref, 0, sizeof ref);
+
+	if ( (len = readfile(dirfd, "stat", buf, sizeof buf)) <= 0)
+		return;		// task vanished
+
+	fp    = fmemopen(buf, len, "r");
+	refrv = refstat(&ref, fp, BOOTEPOCH, isproc);
+	fclose(fp);
+
+	newrv = parsestat(&new, buf, BOOTEPOCH, isproc);
+
+	if ( (len = readfile(dirfd, "status", buf, sizeof buf)) > 0)
+	{
+		fp = fmemopen(buf, len, "r");
+		refstatus(&ref, fp);
+		fclose(fp);
+
+		parsestatus(&new, buf);
+	}
+
+	if ( (len = readfile(dirfd, "io", buf, sizeof buf)) > 0)
+	{
+		fp = fmemopen(buf, len, "r");
+		refio(&ref, fp);
+		fclose(fp);
+
+		parseio(&new, buf);
+	}
+
+	if ( (len = readfile(dirfd, "schedstat", buf, sizeof buf)) > 0)
+	{
+		fp = fmemopen(buf, len, "r");
+		refschedstat(&ref, fp);
+		fclose(fp);
+
+		new.cpu.rundelay = parseschedstat(buf);
+	}
+
+	nsamples++;
+
+	if (newrv != refrv || memcmp(&new, &ref, sizeof new) != 0)
+	{
+		printf("FAIL %s: tstat differs\n", label);
+		nfailed++;
+	}
+}
+
+/*
+** keep the files of a captured sample in memory for the timing
+*/
+static void
+addbench(int dirfd, char isproc)
+{
+	struct benchsample	*bs = &benchsamps[nbench];
+	int			i;
+
+	if (nbench == MAXBENCH)
+		return;
+
+	bs->isproc = isproc;
+
+	for (i=0; i < NBENCHFILES; i++)
+		bs->len[i] = readfile(dirfd, benchfiles[i],
+					bs->buf[i], sizeof bs->buf[i]);
+
+	nbench++;
+}
+
+/*
+** parse one file of all captured samples repeatedly with either the
+** former parser (ref) or the new parser
+**
+** returns: average number of nanoseconds per parsed file
+*/
+static long long
+benchparse(int file, int ref)
+{
+	struct timespec		start, end;
+	struct benchsample	*bs;
+	struct tstat		tstat;
+	long long		nparsed = 0;
+	FILE			*fp;
+	int			i, n;
+
+	memset(&tstat, 0, sizeof tstat);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	for (i=0; i < NBENCHLOOPS; i++)
+	{
+		for (n=0, bs=benchsamps; n < nbench; n++, bs++)
+		{
+			if (bs->len[file] <= 0)
+				continue;
+
+			if (ref)
+			{
+				fp = fmemopen(bs->buf[file], bs->len[file], "r");
+
+				switch (file)
+				{
+				   case 0:
+					refstat(&tstat, fp, BOOTEPOCH, bs->isproc);
+					break;
+				   case 1:
+					refstatus(&tstat, fp);
+					break;
+				   case 2:
+					refio(&tstat, fp);
+					break;
+				   case 3:
+					refschedstat(&tstat, fp);
+					break;
+				}
+
+				fclose(fp);
+			}
+			else
+			{
+				switch (file)
+				{
+				   case 0:
+					parsestat(&tstat, bs->buf[file],
+						BOOTEPOCH, bs->isproc);
+					break;
+				   case 1:
+					parsestatus(&tstat, bs->buf[file]);
+					break;
+				   case 2:
+					parseio(&tstat, bs->buf[file]);
+					break;
+				   case 3:
+					tstat.cpu.rundelay =
+						parseschedstat(bs->buf[file]);
+					break;
+				}
+			}
+
+			nparsed++;
+		}
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	if (nparsed == 0)
+		return 0;
+
+	return ((end.tv_sec  - start.tv_sec) * 1000000000LL +
+	         end.tv_nsec - start.tv_nsec) / nparsed;
+}
+
+/*
+** report the parsing time per file of the former and the new parsers
+*/
+static void
+benchsamples(void)
+{
+	long long	refns, newns;
+	int		i;
+
+	printf("timing of %d captured samples (%d loops):\n",
+			nbench, NBENCHLOOPS);
+
+	for (i=0; i < NBENCHFILES; i++)
+	{
+		refns = benchparse(i, 1);
+		newns = benchparse(i, 0);
+
+		printf("      %-10s former %6lld ns  new %6lld ns",
+			benchfiles[i], refns, newns);
+
+		if (newns)
+			printf("  (%.1fx)", (double)refns / newns);
+
+		printf("\n");
+	}
+}
+
+/*
+** test all captured samples (one subdirectory per task)
+*/
+static void
+testsamples(const char *dirname)
+{
+	DIR		*dirp;
+	struct dirent	*entp;
+	char		label[512];
+	int		fd;
+
+	if ( (dirp = opendir(dirname)) == NULL)
+	{
+		printf("FAIL %s: no captured samples\n", dirname);
+		nfailed++;
+		return;
+	}
+
+	while ( (entp = readdir(dirp)) )
+	{
+		if (entp->d_name[0] == '.')
+			continue;
+
+		if ( (fd = openat(dirfd(dirp), entp->d_name,
+					O_RDONLY|O_DIRECTORY)) == -1)
+			continue;
+
+		snprintf(label, sizeof label, "%s/%s", dirname, entp->d_name);
+
+		testtask(fd, label, strcmp(entp->d_name, "thread") != 0);
+		addbench(fd, strcmp(entp->d_name, "thread") != 0);
+
+		close(fd);
+	}
+
+	closedir(dirp);
+}
+
+/*
+** test all running processes and their threads
+*/
+static void
+testrunning(void)
+{
+	DIR		*procdir, *taskdir;
+	struct dirent	*pent, *tent;
+	char		label[600];
+	int		pfd, tfd, tdfd;
+
+	if ( (procdir = opendir("/proc")) == NULL)
+		return;
+
+	while ( (pent = readdir(procdir)) )
+	{
+		if (pent->d_name[0] < '0' || pent->d_name[0] > '9')
+			continue;
+
+		if ( (pfd = openat(dirfd(procdir), pent->d_name,
+					O_RDONLY|O_DIRECTORY)) == -1)
+			continue;
+
+		snprintf(label, sizeof label, "/proc/%s", pent->d_name);
+		testtask(pfd, label, 1);
+
+		if ( (tdfd = openat(pfd, "task", O_RDONLY|O_DIRECTORY)) != -1 &&
+		     (taskdir = fdopendir(tdfd)) != NULL)
+		{
+			while ( (tent = readdir(taskdir)) )
+			{
+				if (tent->d_name[0] == '.')
+					continue;
+
+				if ( (tfd = openat(dirfd(taskdir), tent->d_name,
+						O_RDONLY|O_DIRECTORY)) == -1)
+					continue;
+
+				snprintf(label, sizeof label, "/proc/%s/task/%s",
+						pent->d_name, tent->d_name);
+				testtask(tfd, label, 0);
+
+				close(tfd);
+			}
+
+			closedir(taskdir);
+		}
+
+		close(pfd);
+	}
+
+	closedir(procdir);
+}
+
+int
+main(int argc, char *argv[])
+{
+	testsamples(argc > 1 ? argv[1] : "tests/procsamples");
+	testrunning();
+	benchsamples();
+
+	printf("%s  %d tasks parsed, %d different\n",
+			nfailed ? "FAIL" : "ok  ", nsamples, nfailed);
+
+	return nfailed ? 1 : 0;
+}
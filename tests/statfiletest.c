@@ -0,0 +1,159 @@
+/*
+** ATOP - System & Process Monitor
+**
+** Test of the registry of statistics files (statfile.c): the contents
+** offered by sfopen() should be identical to the contents obtained by
+** reading the file in the conventional way, also for procfs files that
+** are larger than one page (delivered by the kernel in chunks).
+** ==========================================================================
+**
+** This program is free software; you can redistribute it and/or modify it
+** under the terms of the GNU General Public License as published by the
+** Free Software Foundation; either version 2, or (at your option) any
+** later version.
+**
+** This program is distributed in the hope that it will be useful, but
+** WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU General Public License for more details.
+*/
+
+#include <sys/types.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "atop.h"
+#include "statfile.h"
+
+/*
+** multi-page procfs files with contents that do not change
+** between two reads
+*/
+static const char *testfiles[] = {
+	"/proc/kallsyms",
+	"/proc/self/mountinfo",
+	"/proc/self/mountstats",
+};
+
+/*
+** functions of various.c that are used by statfile.c
+*/
+void
+ptrverify(const void *ptr, const char *errormsg, ...)
+{
+	if (!ptr)
+	{
+		fprintf(stderr, "%s", errormsg);
+		exit(2);
+	}
+}
+
+void
+safe_strcpy(char *dst, const char *src, size_t size)
+{
+	snprintf(dst, size, "%s", src);
+}
+
+/*
+** read the complete file in the conventional way
+*/
+static char *
+readall(const char *path, size_t *lenp)
+{
+	size_t	size = 4096, len = 0;
+	ssize_t	n;
+	char	*buf = malloc(size);
+	int	fd;
+
+	if ( (fd = open(path, O_RDONLY)) == -1)
+		return NULL;
+
+	while ( (n = read(fd, buf+len, size-len)) > 0)
+	{
+		len += n;
+
+		if (len == size)
+			buf = realloc(buf, size *= 2);
+	}
+
+	close(fd);
+
+	*lenp = len;
+	return buf;
+}
+
+/*
+** read the file via sfopen() (twice, to verify the reread of
+** an already registered file as well)
+*/
+static int
+testfile(const char *path)
+{
+	char	*expect, *buf;
+	size_t	explen, len, size;
+	FILE	*fp;
+	int	pass, c, failed = 0;
+
+	if ( (expect = readall(path, &explen)) == NULL || explen <= 4096)
+	{
+		printf("SKIP %s (not available or not larger than one page)\n",
+									path);
+		free(expect);
+		return 0;
+	}
+
+	for (pass=1; pass <= 2; pass++)
+	{
+		if ( (fp = sfopen(path)) == NULL)
+		{
+			printf("FAIL %s: sfopen failed\n", path);
+			return 1;
+		}
+
+		buf = malloc(size = explen + 1);
+
+		for (len=0; (c = getc(fp)) != EOF; len++)
+		{
+			if (len == size)
+				buf = realloc(buf, size *= 2);
+
+			buf[len] = c;
+		}
+
+		fclose(fp);
+
+		if (len != explen || memcmp(buf, expect, len) != 0)
+		{
+			printf("FAIL %s (pass %d): %zu bytes instead of %zu\n",
+						path, pass, len, explen);
+			failed = 1;
+		}
+		else
+		{
+			printf("ok   %s (pass %d): %zu bytes\n",
+						path, pass, len);
+		}
+
+		free(buf);
+	}
+
+	free(expect);
+
+	return failed;
+}
+
+int
+main(void)
+{
+	unsigned int	i;
+	int		failed = 0;
+
+	for (i=0; i < sizeof testfiles / sizeof testfiles[0]; i++)
+		failed |= testfile(testfiles[i]);
+
+	return failed;
+}
@@ -34,6 +34,7 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <sched.h>
@@ -46,6 +47,28 @@
 
 static	int		mypidfd, foreignuts;
 
+// Cache of the host names per UTS namespace, keyed by the inode
+// number of the namespace, to avoid a setns() and gethostname()
+// for every process in a container/pod during every sample.
+// Entries of namespaces that are not referred to any more during
+// a sample are removed by resetutsname().
+//
+#define	NUTSHASH	256		// MUST be a power of 2 !!!
+
+struct utsent {
+	struct utsent		*next;		// next in hash chain
+	unsigned long		inode;		// inode of UTS namespace
+	unsigned long		lastseen;	// sample number of last use
+	char			container;	// boolean: container/pod?
+	char			hostname[UTSLEN+1];
+};
+
+static struct utsent	*utshash[NUTSHASH];
+static unsigned long	utssample;
+
+static struct utsent	*utssearch(unsigned long);
+static void		utsinsert(unsigned long, char, char *);
+
 // Function that fills the host name (container/pod name) of 
 // a specific process.
 // When the process has a different UTS namespace then systemd,
@@ -65,7 +88,9 @@ getutsname(struct tstat *curtask)
 
 	int		pidfd, offset;
 	ssize_t		destlen;
-	char		srcpath[64], destpath[64], tmphost[70];
+	char		srcpath[64], destpath[64], tmphost[70], *p;
+	unsigned long	inode = 0;
+	struct utsent	*up;
 
 	// regain root privs in case of setuid root executable
 	//
@@ -127,12 +152,36 @@ getutsname(struct tstat *curtask)
 	//
 	snprintf(srcpath, sizeof srcpath, UTSPATH, curtask->gen.pid);
 
-	destlen = readlink(srcpath, destpath, sizeof destpath);
+	if ( (destlen = readlink(srcpath, destpath, sizeof destpath - 1)) == -1)
+		goto drop_and_return;
+
 	destpath[destlen] = '\0';
 
 	if (strcmp(basepath, destpath) == 0)	// equal?
 		goto drop_and_return;
 
+	// the host name related to this UTS namespace might already
+	// be known, using the inode number in the link ("uts:[inode]")
+	//
+	if ( (p = strchr(destpath, '[')) )
+	{
+		inode = strtoul(p+1, NULL, 10);
+
+		if ( (up = utssearch(inode)) )
+		{
+			up->lastseen = utssample;
+
+			if (! droprootprivs())
+				mcleanstop(42, "failed to drop root privs\n");
+
+			if (!up->container)
+				return 0;
+
+			strcpy(curtask->gen.utsname, up->hostname);
+			return 1;
+		}
+	}
+
 	// UTS namespace deviates from base UTS namespace
 	// 
 	// get hostname related to this UTS namespace by associating
@@ -159,7 +208,12 @@ getutsname(struct tstat *curtask)
 	// and will be skipped as well
 	//
 	if ( strcmp(tmphost, basehost) == 0 || strcmp(tmphost, "localhost") == 0)
+	{
+		if (inode)
+			utsinsert(inode, 0, "");
+
 		goto drop_and_return;
+	}
 
 	// this process really seems to be container/pod related
 	//
@@ -168,6 +222,9 @@ getutsname(struct tstat *curtask)
 
 	strcpy(curtask->gen.utsname, tmphost+offset);	// copy last part when overflow
 
+	if (inode)
+		utsinsert(inode, 1, curtask->gen.utsname);
+
 	if (! droprootprivs())
 		mcleanstop(42, "failed to drop root privs\n");
 
@@ -180,11 +237,73 @@ getutsname(struct tstat *curtask)
         return 0;
 }
 
+// Search the cache entry of the UTS namespace with the given inode
+//
+static struct utsent *
+utssearch(unsigned long inode)
+{
+	struct utsent	*up;
+
+	for (up = utshash[inode&(NUTSHASH-1)]; up; up = up->next)
+	{
+		if (up->inode == inode)
+			return up;
+	}
+
+	return NULL;
+}
+
+// Add a cache entry for the UTS namespace with the given inode
+//
+static void
+utsinsert(unsigned long inode, char container, char *hostname)
+{
+	struct utsent	*up;
+
+	up = calloc(1, sizeof *up);
+
+	ptrverify(up, "Malloc failed for UTS namespace cache\n");
+
+	up->inode	= inode;
+	up->lastseen	= utssample;
+	up->container	= container;
+
+	safe_strcpy(up->hostname, hostname, sizeof up->hostname);
+
+	up->next = utshash[inode&(NUTSHASH-1)];
+	utshash[inode&(NUTSHASH-1)] = up;
+}
+
 // Reassociate atop with its own UTS namespace
+// and remove the cache entries of the UTS namespaces
+// that were not referred to during this sample (vanished)
 //
 void
 resetutsname(void)
 {
+	struct utsent	**upp, *up;
+	int		i;
+
+	for (i=0; i < NUTSHASH; i++)
+	{
+		for (upp = &utshash[i]; *upp; )
+		{
+			up = *upp;
+
+			if (up->lastseen != utssample)
+			{
+				*upp = up->next;
+				free(up);
+			}
+			else
+			{
+				upp = &up->next;
+			}
+		}
+	}
+
+	utssample++;
+
 	// switch back to my own original UTS namespace
 	//
 	if (foreignuts)